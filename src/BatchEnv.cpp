@@ -0,0 +1,255 @@
+#include "BatchEnv.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float survivalReward = 1.0f; // per simulated second
+const float killReward = 1.0f;
+const float deathPenalty = -1.0f;
+const float winReward = 1.0f;
+
+}
+
+BatchEnv::BatchEnv(const Config& config) : m_config(config) {
+    m_config.arenas = std::max(1, m_config.arenas);
+    m_config.bots = std::max(1, m_config.bots);
+    m_config.patch = std::clamp(m_config.patch, 3, 63);
+    m_config.actionRepeat = std::max(1, m_config.actionRepeat);
+    m_config.tickRate = std::clamp(m_config.tickRate, 10, 240);
+
+    const int k = m_config.arenas, p = m_config.patch;
+
+    m_arenas.resize(k);
+    m_patches.assign(static_cast<size_t>(k) * p * p, 0);
+    m_states.assign(static_cast<size_t>(k) * StateSize, 0.0f);
+    m_rewards.assign(k, 0.0f);
+    m_dones.assign(k, 0);
+
+    for (int i = 0; i < k; ++i) {
+        GameSimulation& sim = m_arenas[i].sim;
+
+        sim.setFieldSize(m_config.fieldSize);
+        sim.setHumanSlots(1);
+        sim.setBotCount(m_config.bots);
+        sim.setSeed(m_config.seed * 0x9E3779B97F4A7C15ull + static_cast<quint64>(i) * 0xD1B54A32D192ED03ull);
+    }
+
+    int threads = m_config.threads > 0 ? m_config.threads : static_cast<int>(std::thread::hardware_concurrency());
+
+    m_threadCount = std::clamp(threads, 1, k);
+
+    // the calling thread takes the first share itself
+    for (int w = 1; w < m_threadCount; ++w) m_workers.emplace_back([this, w]() { workerLoop(w); });
+
+    reset();
+}
+
+BatchEnv::~BatchEnv() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_wake.notify_all();
+
+    for (std::thread& w : m_workers) w.join();
+}
+
+int BatchEnv::arenas() const { return m_config.arenas; }
+
+int BatchEnv::patchSize() const { return m_config.patch; }
+
+const quint8* BatchEnv::patches() const { return m_patches.data(); }
+
+const float* BatchEnv::states() const { return m_states.data(); }
+
+const float* BatchEnv::rewards() const { return m_rewards.data(); }
+
+const quint8* BatchEnv::dones() const { return m_dones.data(); }
+
+bool BatchEnv::reset() {
+    m_jobIsReset = true;
+
+    return runJob();
+}
+
+bool BatchEnv::step(const qint32* actions) {
+    m_actions = actions;
+    m_jobIsReset = false;
+
+    return runJob();
+}
+
+// an exception must not leave a worker thread, and the caller has to wait for the other shares anyway
+void BatchEnv::runArena(int k) {
+    try {
+        if (m_jobIsReset) resetArena(k);
+        else stepArena(k);
+    } catch (...) {
+        m_failed.store(true, std::memory_order_relaxed);
+    }
+}
+
+// hands the current job to the pool, runs the first share here and waits for the rest
+bool BatchEnv::runJob() {
+    const int threads = m_threadCount;
+
+    m_failed.store(false, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+        m_pending = threads - 1;
+    }
+
+    m_wake.notify_all();
+
+    const int share = (m_config.arenas + threads - 1) / threads;
+
+    for (int k = 0; k < std::min(share, m_config.arenas); ++k) runArena(k);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this]() { return m_pending == 0; });
+
+    return !m_failed.load(std::memory_order_relaxed);
+}
+
+void BatchEnv::workerLoop(int worker) {
+    const int threads = m_threadCount;
+    quint64 seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+
+            if (m_quit) return;
+
+            seen = m_generation;
+        }
+
+        const int share = (m_config.arenas + threads - 1) / threads;
+        const int begin = std::min(worker * share, m_config.arenas), end = std::min(begin + share, m_config.arenas);
+
+        for (int k = begin; k < end; ++k) runArena(k);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (--m_pending == 0) m_finished.notify_one();
+    }
+}
+
+void BatchEnv::resetArena(int k) {
+    Arena& a = m_arenas[k];
+
+    a.sim.resetRound();
+    ++a.episodes;
+    m_rewards[k] = 0.0f;
+    m_dones[k] = 0;
+    observe(k);
+}
+
+void BatchEnv::stepArena(int k) {
+    Arena& a = m_arenas[k];
+    GameSimulation& sim = a.sim;
+    const float dt = 1.0f / static_cast<float>(m_config.tickRate);
+    float reward = 0.0f;
+    bool done = false;
+
+    sim.setTurnInput(0, static_cast<float>(std::clamp(m_actions[k], 0, 2) - 1));
+
+    for (int r = 0; r < m_config.actionRepeat && !done; ++r) {
+        sim.step(dt);
+        sim.expireTrails();
+
+        for (int idx : sim.killedLastStep()) {
+            if (idx != 0 && sim.killedBy(idx) == 0) reward += killReward;
+        }
+
+        if (!sim.bikes()[0].alive) {
+            reward += deathPenalty;
+            done = true;
+        } else {
+            reward += survivalReward * dt;
+
+            if (sim.aliveCount() == 1) {
+                reward += winReward;
+                done = true;
+            } else if (sim.time() >= m_config.maxSeconds) {
+                done = true;
+            }
+        }
+    }
+
+    if (done) {
+        sim.resetRound();
+        ++a.episodes;
+    }
+
+    m_rewards[k] = reward;
+    m_dones[k] = done ? 1 : 0;
+    observe(k);
+}
+
+void BatchEnv::observe(int k) {
+    Arena& a = m_arenas[k];
+    const GameSimulation& sim = a.sim;
+    const float half = sim.mapHalfSize(), cell = sim.cellSize(), inv = 1.0f / cell;
+    const int p = m_config.patch;
+    const GameSimulation::Bike& me = sim.bikes()[0];
+    const QVector3D forward = GameSimulation::forwardFromYaw(me.yaw);
+    const QVector3D right(forward.z(), 0.0f, -forward.x());
+    const int selfRow = p * 3 / 4, selfCol = p / 2;
+    quint8* patch = m_patches.data() + static_cast<size_t>(k) * p * p;
+
+    // patch cells whose centre lies outside the arena are wall
+    for (int r = 0; r < p; ++r) {
+        for (int c = 0; c < p; ++c) {
+            const QVector3D w = me.pos + forward * (static_cast<float>(selfRow - r) * cell) + right * (static_cast<float>(c - selfCol) * cell);
+
+            patch[r * p + c] = std::abs(w.x()) > half || std::abs(w.z()) > half ? 1 : 0;
+        }
+    }
+
+    // trail points are splatted straight into the learner's frame; they are spaced far closer than a cell
+    for (const auto& trail : sim.trails()) {
+        for (const GameSimulation::TrailPoint& tp : trail) {
+            const QVector3D v = sim.trailPos(tp) - me.pos;
+            const int r = selfRow - static_cast<int>(std::lround(QVector3D::dotProduct(v, forward) * inv));
+            const int c = selfCol + static_cast<int>(std::lround(QVector3D::dotProduct(v, right) * inv));
+
+            if (r >= 0 && r < p && c >= 0 && c < p) patch[r * p + c] = 1;
+        }
+    }
+
+    float* state = m_states.data() + static_cast<size_t>(k) * StateSize;
+    const auto& bikes = sim.bikes();
+    float nearest = -1.0f;
+    int alive = 0;
+
+    state[PosX] = me.pos.x() / half;
+    state[PosZ] = me.pos.z() / half;
+    state[HeadingSin] = -forward.x();
+    state[HeadingCos] = -forward.z();
+    state[Speed] = me.speed / sim.maxForwardSpeed();
+    state[RivalAhead] = 0.0f;
+    state[RivalRight] = 0.0f;
+
+    for (size_t j = 1; j < bikes.size(); ++j) {
+        if (!bikes[j].alive) continue;
+
+        const QVector3D v = bikes[j].pos - me.pos;
+        const float d2 = v.lengthSquared();
+
+        ++alive;
+
+        if (nearest < 0.0f || d2 < nearest) {
+            nearest = d2;
+            state[RivalAhead] = QVector3D::dotProduct(v, forward) / half;
+            state[RivalRight] = QVector3D::dotProduct(v, right) / half;
+        }
+    }
+
+    state[AliveRivals] = static_cast<float>(alive) / static_cast<float>(m_config.bots);
+}
@@ -0,0 +1,104 @@
+#ifndef BATCHENV_H
+#define BATCHENV_H
+
+// Batched training environment: K independent seeded arenas stepped together.
+// In every arena bike 0 is the learner and the rest are classic bots. Each step
+// takes one action per arena (0 = left, 1 = straight, 2 = right) and fills flat
+// arrays that stay at the same address for the life of the object:
+//   patches  K * patch * patch bytes, occupancy around the learner in its own
+//            frame (row 0 is furthest ahead, the learner sits in the centre of
+//            the bottom half); walls and trails are 1
+//   states   K * stateSize floats, see the State enum
+//   rewards  K floats, dones K bytes
+// A finished arena is reset inside the same step, so its observation is already
+// the first one of the next episode. Arenas are split over a fixed pool of
+// threads. The first episode of each arena still allocates while the
+// simulation's pools grow to their working size; later ones do not.
+
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "GameSimulation.h"
+
+class BatchEnv {
+public:
+    struct Config {
+        int arenas = 64;
+        int bots = 3;
+        int fieldSize = 60;
+        int patch = 15;
+        // simulation ticks per action
+        int actionRepeat = 2;
+        int tickRate = 60;
+        float maxSeconds = 60.0f;
+        int threads = 0;
+        quint64 seed = 1;
+    };
+
+    enum State {
+        PosX,
+        PosZ,
+        HeadingSin,
+        HeadingCos,
+        Speed,
+        // nearest living rival in the learner's frame, scaled by the arena half size
+        RivalAhead,
+        RivalRight,
+        AliveRivals,
+        StateSize
+    };
+
+    explicit BatchEnv(const Config& config);
+    ~BatchEnv();
+    BatchEnv(const BatchEnv&) = delete;
+    BatchEnv& operator=(const BatchEnv&) = delete;
+
+    int arenas() const;
+    int patchSize() const;
+    // false if an arena threw (out of memory, say); the outputs are then undefined until a reset succeeds
+    bool reset();
+    bool step(const qint32* actions);
+
+    const quint8* patches() const;
+    const float* states() const;
+    const float* rewards() const;
+    const quint8* dones() const;
+private:
+    struct Arena {
+        GameSimulation sim;
+        quint64 episodes = 0;
+    };
+
+    void resetArena(int k);
+    void stepArena(int k);
+    void observe(int k);
+    void runArena(int k);
+    bool runJob();
+    void workerLoop(int worker);
+
+    Config m_config;
+    std::vector<Arena> m_arenas;
+    std::vector<quint8> m_patches;
+    std::vector<float> m_states;
+    std::vector<float> m_rewards;
+    std::vector<quint8> m_dones;
+    const qint32* m_actions = nullptr;
+    // what the pool runs over every arena: a reset or a step with m_actions
+    bool m_jobIsReset = false;
+
+    int m_threadCount = 1;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    quint64 m_generation = 0;
+    int m_pending = 0;
+    bool m_quit = false;
+    // set by any arena of the current job that threw
+    std::atomic<bool> m_failed{false};
+};
+
+#endif // BATCHENV_H
@@ -0,0 +1,234 @@
+#include "BotTuner.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <thread>
+
+namespace {
+
+// search box per gene, in BotParams order
+const float lowerBound[8] = {20.0f, 0.5f, 0.0f, -0.5f, 0.1f, 0.0f, 0.0f, 0.0f};
+const float upperBound[8] = {300.0f, 6.0f, 2500.0f, 0.95f, 2.0f, 3.0f, 0.5f, 300.0f};
+
+const int elites = 2;
+const int tournament = 3;
+const double mutationChance = 0.3;
+// mutation step as a share of each gene's range
+const double mutationScale = 0.1;
+
+}
+
+BotTuner::BotTuner(const Config& config) : m_config(config) {
+    m_config.population = std::max(elites + 1, m_config.population);
+    m_config.generations = std::max(1, m_config.generations);
+    m_config.matches = std::max(2, m_config.matches);
+    m_config.bots = std::max(2, m_config.bots);
+    m_config.tickRate = std::clamp(m_config.tickRate, 10, 240);
+    m_rng = m_config.seed * 0x9E3779B97F4A7C15ull + 1;
+}
+
+BotTuner::Genome BotTuner::toGenome(const GameSimulation::BotParams& p) {
+    return {p.lookAheadDist, p.avoidThreshold, p.attackDist2, p.minDotAttack, p.wanderMin, p.wanderRange, p.wanderTurnChance, p.huntDist};
+}
+
+GameSimulation::BotParams BotTuner::fromGenome(const Genome& g) {
+    GameSimulation::BotParams p;
+    p.lookAheadDist = g[0];
+    p.avoidThreshold = g[1];
+    p.attackDist2 = g[2];
+    p.minDotAttack = g[3];
+    p.wanderMin = g[4];
+    p.wanderRange = g[5];
+    p.wanderTurnChance = g[6];
+    p.huntDist = g[7];
+
+    return p;
+}
+
+// xorshift64*
+double BotTuner::random01() {
+    m_rng ^= m_rng >> 12;
+    m_rng ^= m_rng << 25;
+    m_rng ^= m_rng >> 27;
+
+    return static_cast<double>((m_rng * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double BotTuner::gaussian() {
+    const double u = std::max(random01(), 1e-12), v = random01();
+
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * 3.14159265358979 * v);
+}
+
+quint64 BotTuner::matchSeed(int generation, int match) const {
+    return m_config.seed * 1000003ull + static_cast<quint64>(generation) * static_cast<quint64>(m_config.matches) + static_cast<quint64>(match);
+}
+
+BotTuner::Outcome BotTuner::playMatch(const GameSimulation::BotParams& candidate, quint64 seed, bool candidateFirst) const {
+    const GameSimulation::BotParams reference;
+    const float dt = 1.0f / static_cast<float>(m_config.tickRate);
+    const int maxTicks = static_cast<int>(m_config.maxSeconds * m_config.tickRate);
+    GameSimulation sim;
+
+    sim.setFieldSize(m_config.fieldSize);
+    sim.setHumanSlots(0);
+    sim.setBotCount(m_config.bots);
+    sim.setSeed(seed);
+
+    // bike 0 is who the classic bots chase, so it alternates between the teams
+    auto isCandidate = [candidateFirst](int i) { return (i % 2 == 0) == candidateFirst; };
+
+    for (int i = 0; i < m_config.bots; ++i) sim.setBotParams(i, isCandidate(i) ? candidate : reference);
+
+    sim.resetRound();
+
+    std::vector<int> deathTick(m_config.bots, maxTicks);
+
+    for (int tick = 0; tick < maxTicks && sim.aliveCount() > 1; ++tick) {
+        sim.step(dt);
+        sim.expireTrails();
+
+        for (int idx : sim.killedLastStep()) deathTick[idx] = tick;
+    }
+
+    Outcome o;
+
+    for (int i = 0; i < m_config.bots; ++i) {
+        const int killer = sim.killedBy(i);
+
+        if (isCandidate(i)) o.candidateSurvival += deathTick[i];
+        else o.referenceSurvival += deathTick[i];
+
+        if (killer >= 0 && isCandidate(killer) != isCandidate(i)) {
+            if (isCandidate(killer)) ++o.candidateKills;
+            else ++o.referenceKills;
+        }
+    }
+
+    return o;
+}
+
+double BotTuner::fitness(const std::vector<Outcome>& outcomes, size_t begin, size_t end) {
+    double candidateSurvival = 0.0, referenceSurvival = 0.0;
+    int candidateKills = 0, referenceKills = 0;
+
+    for (size_t i = begin; i < end; ++i) {
+        candidateSurvival += outcomes[i].candidateSurvival;
+        referenceSurvival += outcomes[i].referenceSurvival;
+        candidateKills += outcomes[i].candidateKills;
+        referenceKills += outcomes[i].referenceKills;
+    }
+
+    const double survivalShare = candidateSurvival + referenceSurvival > 0.0 ? candidateSurvival / (candidateSurvival + referenceSurvival) : 0.5;
+    const double killShare = candidateKills + referenceKills > 0 ? static_cast<double>(candidateKills) / (candidateKills + referenceKills) : 0.5;
+
+    return 0.5 * (survivalShare + killShare);
+}
+
+void BotTuner::parallelFor(int count, const std::function<void(int)>& job) const {
+    int threads = m_config.threads > 0 ? m_config.threads : static_cast<int>(std::thread::hardware_concurrency());
+
+    threads = std::clamp(threads, 1, std::max(1, count));
+
+    std::atomic<int> next{0};
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = next++; i < count; i = next++) job(i);
+        });
+    }
+
+    for (std::thread& w : workers) w.join();
+}
+
+double BotTuner::evaluate(const GameSimulation::BotParams& candidate, int generation) const {
+    std::vector<Outcome> outcomes(m_config.matches);
+
+    parallelFor(m_config.matches, [&](int m) { outcomes[m] = playMatch(candidate, matchSeed(generation, m / 2), m % 2 == 0); });
+
+    return fitness(outcomes, 0, outcomes.size());
+}
+
+BotTuner::Result BotTuner::run(const Progress& progress) {
+    const int population = m_config.population, matches = m_config.matches;
+    std::vector<Genome> genomes(population);
+    std::vector<double> scores(population);
+    std::vector<Outcome> outcomes(static_cast<size_t>(population) * matches);
+    Result best;
+
+    // the reference itself seeds the population so the search can only improve on it
+    genomes[0] = toGenome(GameSimulation::BotParams());
+
+    for (int i = 1; i < population; ++i) {
+        for (int g = 0; g < genes; ++g) genomes[i][g] = static_cast<float>(lowerBound[g] + random01() * (upperBound[g] - lowerBound[g]));
+    }
+
+    for (int generation = 0; generation < m_config.generations; ++generation) {
+        // matches come in side-swapped pairs on the same seed
+        parallelFor(population * matches, [&](int job) {
+            const int who = job / matches, m = job % matches;
+
+            outcomes[job] = playMatch(fromGenome(genomes[who]), matchSeed(generation, m / 2), m % 2 == 0);
+        });
+
+        for (int i = 0; i < population; ++i) scores[i] = fitness(outcomes, static_cast<size_t>(i) * matches, static_cast<size_t>(i + 1) * matches);
+
+        std::vector<int> order(population);
+
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+        best.params = fromGenome(genomes[order[0]]);
+        best.fitness = scores[order[0]];
+
+        if (progress) progress(generation, best, std::accumulate(scores.begin(), scores.end(), 0.0) / population);
+
+        if (generation + 1 == m_config.generations) break;
+
+        auto pick = [&]() {
+            int winner = static_cast<int>(random01() * population);
+
+            for (int k = 1; k < tournament; ++k) {
+                const int other = static_cast<int>(random01() * population);
+
+                if (scores[other] > scores[winner]) winner = other;
+            }
+
+            return winner;
+        };
+
+        std::vector<Genome> next;
+
+        for (int e = 0; e < elites; ++e) next.push_back(genomes[order[e]]);
+
+        while (static_cast<int>(next.size()) < population) {
+            const Genome& a = genomes[pick()];
+            const Genome& b = genomes[pick()];
+            Genome child;
+
+            for (int g = 0; g < genes; ++g) {
+                const double range = upperBound[g] - lowerBound[g];
+                // BLX-0.25: anywhere on the parents' segment, stretched a quarter beyond each end
+                const double alpha = -0.25 + 1.5 * random01();
+                double v = a[g] + alpha * (b[g] - a[g]);
+
+                if (random01() < mutationChance) v += gaussian() * mutationScale * range;
+
+                child[g] = static_cast<float>(std::clamp(v, static_cast<double>(lowerBound[g]), static_cast<double>(upperBound[g])));
+            }
+
+            next.push_back(child);
+        }
+
+        genomes.swap(next);
+    }
+
+    // the winner's score is its best draw on the seeds it was picked for; re-score it on a generation past
+    // the last one, whose seeds no candidate has played, so the reported fitness isn't biased upward
+    best.searchFitness = best.fitness;
+    best.fitness = evaluate(best.params, m_config.generations);
+
+    return best;
+}
@@ -0,0 +1,74 @@
+#ifndef BOTTUNER_H
+#define BOTTUNER_H
+
+// Self-play search over GameSimulation::BotParams.
+// A candidate parameter set plays seeded bot-only matches against the reference
+// set (the hand-picked defaults): half the bikes run each, interleaved around
+// the spawn ring, and the teams swap sides every other match. Fitness is the
+// candidate's share of the total survival time and of the trail kills, averaged,
+// so 0.5 means "as good as the reference".
+// The search is a real-coded genetic algorithm with elitism, tournament
+// selection, blend crossover and Gaussian mutation. Every candidate of a
+// generation meets the same match seeds, and all matches of a generation run on
+// a thread pool; results depend only on the seed, not on the thread count.
+
+#include <QtGlobal>
+#include <array>
+#include <functional>
+#include <vector>
+#include "GameSimulation.h"
+
+class BotTuner {
+public:
+    struct Config {
+        int population = 24;
+        int generations = 30;
+        int matches = 64;
+        int bots = 8;
+        int fieldSize = 100;
+        int tickRate = 60;
+        float maxSeconds = 60.0f;
+        int threads = 0;
+        quint64 seed = 1;
+    };
+
+    struct Result {
+        GameSimulation::BotParams params;
+        // run() returns it measured on held-out matches; during the search it is the in-sample score
+        double fitness = 0.0;
+        // in-sample score of the final pick
+        double searchFitness = 0.0;
+    };
+
+    using Progress = std::function<void(int generation, const Result& best, double meanFitness)>;
+
+    explicit BotTuner(const Config& config);
+    Result run(const Progress& progress);
+    // fitness of `candidate` over the matches of one generation; generation == generations is held out
+    double evaluate(const GameSimulation::BotParams& candidate, int generation) const;
+private:
+    static constexpr int genes = 8;
+    using Genome = std::array<float, genes>;
+
+    struct Outcome {
+        double candidateSurvival = 0.0;
+        double referenceSurvival = 0.0;
+        int candidateKills = 0;
+        int referenceKills = 0;
+    };
+
+    static Genome toGenome(const GameSimulation::BotParams& p);
+    static GameSimulation::BotParams fromGenome(const Genome& g);
+    Outcome playMatch(const GameSimulation::BotParams& candidate, quint64 seed, bool candidateFirst) const;
+    static double fitness(const std::vector<Outcome>& outcomes, size_t begin, size_t end);
+    // runs job(i) for i in [0, count) on the worker threads
+    void parallelFor(int count, const std::function<void(int)>& job) const;
+    quint64 matchSeed(int generation, int match) const;
+    double random01();
+    double gaussian();
+
+    Config m_config;
+    quint64 m_rng;
+};
+
+#endif // BOTTUNER_H
@@ -0,0 +1,209 @@
+#include "DangerField.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// empty 16x16 block rings reach() looks through around a saturated cell
+const int maxReachRings = 4;
+
+}
+
+void DangerField::reset(int width, int height) {
+    m_width = std::max(1, width);
+    m_height = std::max(1, height);
+    m_points.assign(static_cast<size_t>(m_width) * m_height, 0);
+    m_distance.resize(m_points.size());
+    m_dirty.clear();
+    m_blocks4Width = (m_width + 3) / 4;
+    m_blocks16Width = (m_width + 15) / 16;
+    m_blocks16Height = (m_height + 15) / 16;
+    m_blocks4.assign(static_cast<size_t>(m_blocks4Width) * ((m_height + 3) / 4), 0);
+    m_blocks16.assign(static_cast<size_t>(m_blocks16Width) * m_blocks16Height, 0);
+
+    for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) m_distance[y * m_width + x] = static_cast<quint8>(std::min(maxDistance, edgeDistance(x, y)));
+    }
+}
+
+int DangerField::width() const { return m_width; }
+
+int DangerField::height() const { return m_height; }
+
+const quint8* DangerField::data() const { return m_distance.data(); }
+
+int DangerField::edgeDistance(int x, int y) const { return std::min(std::min(x + 1, y + 1), std::min(m_width - x, m_height - y)); }
+
+int DangerField::distance(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return 0;
+
+    return m_distance[y * m_width + x];
+}
+
+void DangerField::addPoint(int x, int y) {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return;
+
+    if (m_points[y * m_width + x]++ == 0) {
+        countBlocks(x, y, 1);
+        markDirty(x, y);
+    }
+}
+
+void DangerField::removePoint(int x, int y) {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return;
+
+    quint16& n = m_points[y * m_width + x];
+
+    if (n > 0 && --n == 0) {
+        countBlocks(x, y, -1);
+        markDirty(x, y);
+    }
+}
+
+void DangerField::countBlocks(int x, int y, int delta) {
+    m_blocks4[(y >> 2) * m_blocks4Width + (x >> 2)] += delta;
+    m_blocks16[(y >> 4) * m_blocks16Width + (x >> 4)] += delta;
+}
+
+// 16x16 blocks first, their 4x4 quarters where a block is only partly covered, cells last
+bool DangerField::empty(int x0, int y0, int x1, int y1) const {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_width - 1);
+    y1 = std::min(y1, m_height - 1);
+
+    for (int by = y0 >> 4; by <= y1 >> 4 && x0 <= x1; ++by) {
+        for (int bx = x0 >> 4; bx <= x1 >> 4; ++bx) {
+            if (m_blocks16[by * m_blocks16Width + bx] == 0) continue;
+
+            const int cx0 = std::max(x0, bx << 4), cy0 = std::max(y0, by << 4);
+            const int cx1 = std::min(x1, (bx << 4) + 15), cy1 = std::min(y1, (by << 4) + 15);
+
+            for (int qy = cy0 >> 2; qy <= cy1 >> 2; ++qy) {
+                for (int qx = cx0 >> 2; qx <= cx1 >> 2; ++qx) {
+                    if (m_blocks4[qy * m_blocks4Width + qx] == 0) continue;
+
+                    const int sx0 = std::max(cx0, qx << 2), sy0 = std::max(cy0, qy << 2);
+                    const int sx1 = std::min(cx1, (qx << 2) + 3), sy1 = std::min(cy1, (qy << 2) + 3);
+
+                    if (sx0 == qx << 2 && sy0 == qy << 2 && sx1 == (qx << 2) + 3 && sy1 == (qy << 2) + 3) return false;
+
+                    for (int y = sy0; y <= sy1; ++y) {
+                        for (int x = sx0; x <= sx1; ++x) {
+                            if (m_points[y * m_width + x]) return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+int DangerField::reach(int x, int y) const {
+    const int d = distance(x, y);
+
+    if (d < maxDistance) return d;
+
+    // grow a square of empty blocks ring by ring around the cell's own block
+    const int bx = x >> 4, by = y >> 4;
+    int rings = 0;
+
+    for (; rings < maxReachRings; ++rings) {
+        bool clear = true;
+
+        for (int ry = by - rings; ry <= by + rings && clear; ++ry) {
+            for (int rx = bx - rings; rx <= bx + rings; ++rx) {
+                if (std::max(std::abs(rx - bx), std::abs(ry - by)) != rings || rx < 0 || ry < 0 || rx >= m_blocks16Width || ry >= m_blocks16Height) continue;
+
+                if (m_blocks16[ry * m_blocks16Width + rx] != 0) {
+                    clear = false;
+                    break;
+                }
+            }
+        }
+
+        if (!clear) break;
+    }
+
+    if (rings == 0) return d;
+
+    // the nearest trail cell is outside the square; the arena edge may be closer still
+    const int left = (bx - rings + 1) << 4, top = (by - rings + 1) << 4, right = (bx + rings) << 4, bottom = (by + rings) << 4;
+    const int free = std::min(std::min(x - left + 1, right - x), std::min(y - top + 1, bottom - y));
+
+    return std::max(d, std::min(free, edgeDistance(x, y)));
+}
+
+// neighbouring changes share one box; trails usually grow and expire a cell at a time
+void DangerField::markDirty(int x, int y) {
+    for (Box& b : m_dirty) {
+        if (x >= b.x0 - maxDistance && x <= b.x1 + maxDistance && y >= b.y0 - maxDistance && y <= b.y1 + maxDistance) {
+            b.x0 = std::min(b.x0, x);
+            b.y0 = std::min(b.y0, y);
+            b.x1 = std::max(b.x1, x);
+            b.y1 = std::max(b.y1, y);
+
+            return;
+        }
+    }
+
+    m_dirty.push_back({x, y, x, y});
+}
+
+void DangerField::flush() {
+    for (const Box& b : m_dirty) recompute(b);
+
+    m_dirty.clear();
+}
+
+void DangerField::recompute(const Box& box) {
+    // cells whose value can change, and the window holding every wall that can matter to them
+    const int ox0 = std::max(0, box.x0 - maxDistance), oy0 = std::max(0, box.y0 - maxDistance);
+    const int ox1 = std::min(m_width - 1, box.x1 + maxDistance), oy1 = std::min(m_height - 1, box.y1 + maxDistance);
+    const int wx0 = std::max(0, ox0 - maxDistance), wy0 = std::max(0, oy0 - maxDistance);
+    const int wx1 = std::min(m_width - 1, ox1 + maxDistance), wy1 = std::min(m_height - 1, oy1 + maxDistance);
+    const int w = wx1 - wx0 + 1, h = wy1 - wy0 + 1;
+
+    m_scratch.resize(static_cast<size_t>(w) * h);
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const int gx = wx0 + x, gy = wy0 + y;
+
+            m_scratch[y * w + x] = m_points[gy * m_width + gx] ? 0 : static_cast<quint8>(std::min(maxDistance, edgeDistance(gx, gy)));
+        }
+    }
+
+    auto relax = [&](int x, int y, int nx, int ny) {
+        if (nx < 0 || ny < 0 || nx >= w || ny >= h) return;
+
+        quint8& d = m_scratch[y * w + x];
+        const int via = m_scratch[ny * w + nx] + 1;
+
+        if (via < d) d = static_cast<quint8>(via);
+    };
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            relax(x, y, x - 1, y);
+            relax(x, y, x - 1, y - 1);
+            relax(x, y, x, y - 1);
+            relax(x, y, x + 1, y - 1);
+        }
+    }
+
+    for (int y = h - 1; y >= 0; --y) {
+        for (int x = w - 1; x >= 0; --x) {
+            relax(x, y, x + 1, y);
+            relax(x, y, x + 1, y + 1);
+            relax(x, y, x, y + 1);
+            relax(x, y, x - 1, y + 1);
+        }
+    }
+
+    for (int gy = oy0; gy <= oy1; ++gy) {
+        for (int gx = ox0; gx <= ox1; ++gx) m_distance[gy * m_width + gx] = m_scratch[(gy - wy0) * w + (gx - wx0)];
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef DANGERFIELD_H
+#define DANGERFIELD_H
+
+// Coarse distance-to-danger map of the arena: for every cell, the chessboard
+// distance in cells to the nearest trail cell or to the arena edge, capped at
+// maxDistance. Trail points are reference-counted per cell, so a cell only
+// turns into a wall on its first point and back on its last. Changes are
+// queued and flush() recomputes just the cells within maxDistance of them: it
+// runs a two-pass chamfer over a window 2 * maxDistance around each dirty box
+// (walls further away can't affect the rewritten cells). Lookups are O(1).
+// Above the cells sits a two-level pyramid counting trail cells per 4x4 and
+// per 16x16 block, kept exact on every wall change. empty() answers rectangle
+// queries a whole empty block at a time, and reach() extends the capped
+// distance by the ring of empty 16x16 blocks around a cell, so rays and
+// searches can cross open arena in one step however large it is.
+
+#include <QtGlobal>
+#include <algorithm>
+#include <vector>
+
+class DangerField {
+public:
+    static constexpr int maxDistance = 8;
+
+    // clears every wall; the edge distances are rebuilt in full
+    void reset(int width, int height);
+    void addPoint(int x, int y);
+    void removePoint(int x, int y);
+    void flush();
+
+    int width() const;
+    int height() const;
+    // outside the arena reads as 0
+    int distance(int x, int y) const;
+    // lower bound on the distance when it is at the cap: free room out to the nearest non-empty 16x16 block
+    int reach(int x, int y) const;
+    // no trail cell inside the inclusive rectangle; the part outside the arena counts as empty
+    bool empty(int x0, int y0, int x1, int y1) const;
+    const quint8* data() const;
+    // f(x, y) for every trail cell, row block by row block; empty blocks are skipped whole, so it
+    // costs about as much as there are walls
+    template <typename F>
+    void forEachWall(F f) const;
+private:
+    struct Box {
+        int x0, y0, x1, y1;
+    };
+
+    void markDirty(int x, int y);
+    void countBlocks(int x, int y, int delta);
+    void recompute(const Box& box);
+    int edgeDistance(int x, int y) const;
+
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<quint16> m_points;
+    // trail cells per block; m_blocks4 is (width / 4) x (height / 4) rounded up, m_blocks16 likewise
+    int m_blocks4Width = 0;
+    int m_blocks16Width = 0;
+    int m_blocks16Height = 0;
+    std::vector<quint16> m_blocks4;
+    std::vector<quint16> m_blocks16;
+    std::vector<quint8> m_distance;
+    std::vector<quint8> m_scratch;
+    std::vector<Box> m_dirty;
+};
+
+template <typename F>
+void DangerField::forEachWall(F f) const {
+    for (int by = 0; by < m_blocks16Height; ++by) {
+        for (int bx = 0; bx < m_blocks16Width; ++bx) {
+            if (m_blocks16[by * m_blocks16Width + bx] == 0) continue;
+
+            for (int qy = by * 4; qy < std::min(by * 4 + 4, (m_height + 3) / 4); ++qy) {
+                for (int qx = bx * 4; qx < std::min(bx * 4 + 4, m_blocks4Width); ++qx) {
+                    if (m_blocks4[qy * m_blocks4Width + qx] == 0) continue;
+
+                    for (int y = qy * 4; y < std::min(qy * 4 + 4, m_height); ++y) {
+                        for (int x = qx * 4; x < std::min(qx * 4 + 4, m_width); ++x) {
+                            if (m_points[y * m_width + x]) f(x, y);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif // DANGERFIELD_H
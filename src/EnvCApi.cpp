@@ -0,0 +1,60 @@
+#include "lohotron_env.h"
+#include "BatchEnv.h"
+
+struct lohotron_env {
+    explicit lohotron_env(const BatchEnv::Config& config) : env(config) {}
+
+    BatchEnv env;
+};
+
+// exceptions must not cross the C boundary
+lohotron_env* lohotron_env_create(int arenas, int bots, int field_size, int patch, int action_repeat, int threads, uint64_t seed) {
+    if (arenas <= 0 || bots <= 0 || field_size < 10 || patch < 3) return nullptr;
+
+    BatchEnv::Config config;
+    config.arenas = arenas;
+    config.bots = bots;
+    config.fieldSize = field_size;
+    config.patch = patch;
+    config.actionRepeat = action_repeat;
+    config.threads = threads;
+    config.seed = seed;
+
+    try {
+        return new lohotron_env(config);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void lohotron_env_destroy(lohotron_env* env) { delete env; }
+
+int lohotron_env_arenas(const lohotron_env* env) { return env->env.arenas(); }
+
+int lohotron_env_patch_size(const lohotron_env* env) { return env->env.patchSize(); }
+
+int lohotron_env_state_size(const lohotron_env*) { return BatchEnv::StateSize; }
+
+int lohotron_env_reset(lohotron_env* env) {
+    try {
+        return env->env.reset() ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int lohotron_env_step(lohotron_env* env, const int32_t* actions) {
+    try {
+        return env->env.step(actions) ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+const uint8_t* lohotron_env_patches(const lohotron_env* env) { return env->env.patches(); }
+
+const float* lohotron_env_states(const lohotron_env* env) { return env->env.states(); }
+
+const float* lohotron_env_rewards(const lohotron_env* env) { return env->env.rewards(); }
+
+const uint8_t* lohotron_env_dones(const lohotron_env* env) { return env->env.dones(); }
@@ -0,0 +1,69 @@
+#include "EventStream.h"
+#include <cstring>
+
+static_assert(sizeof(GameEvent) == 16, "an event fills exactly two slot words");
+static_assert((EventStream::capacity & (EventStream::capacity - 1)) == 0, "the ring wraps with a mask");
+
+EventStream::EventStream() {
+    for (Slot& s : m_slots) {
+        for (auto& w : s.words) w.store(0, std::memory_order_relaxed);
+    }
+}
+
+quint64 EventStream::written() const { return m_written.load(std::memory_order_acquire); }
+
+EventStream::Reader EventStream::reader() const {
+    Reader r;
+
+    r.next = written();
+
+    return r;
+}
+
+void EventStream::push(const GameEvent& e) {
+    const quint64 seq = m_written.load(std::memory_order_relaxed);
+    Slot& s = m_slots[seq & (capacity - 1)];
+    quint64 words[slotWords];
+
+    std::memcpy(words, &e, sizeof words);
+
+    // seqlock write: mark the slot busy, fill it, then publish the new number
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int k = 0; k < slotWords; ++k) s.words[k].store(words[k], std::memory_order_relaxed);
+
+    s.seq.store(seq + 1, std::memory_order_release);
+    m_written.store(seq + 1, std::memory_order_release);
+}
+
+int EventStream::read(Reader& r, GameEvent* out, int max) const {
+    const quint64 end = written();
+    int count = 0;
+
+    if (end - r.next > static_cast<quint64>(capacity)) {
+        r.lost += static_cast<qint64>(end - capacity - r.next);
+        r.next = end - capacity;
+    }
+
+    for (; r.next < end && count < max; ++r.next) {
+        const Slot& s = m_slots[r.next & (capacity - 1)];
+        const quint64 before = s.seq.load(std::memory_order_acquire);
+        quint64 words[slotWords];
+
+        for (int k = 0; k < slotWords; ++k) words[k] = s.words[k].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // overwritten before or while we copied it
+        if (before != r.next + 1 || s.seq.load(std::memory_order_relaxed) != before) {
+            ++r.lost;
+
+            continue;
+        }
+
+        std::memcpy(&out[count++], words, sizeof words);
+    }
+
+    return count;
+}
@@ -0,0 +1,74 @@
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+// Gameplay events (kills, near misses, round and match ends) on a fixed ring
+// that one thread writes and any number of readers drain at their own pace,
+// each with its own Reader. Writing never waits and never allocates: the
+// newest event overwrites the oldest, and a reader that has fallen more than
+// `capacity` events behind skips ahead and counts what it lost. Every slot
+// carries the sequence number of the event in it; a reader copies the slot
+// and keeps the copy only if that number didn't change meanwhile, so nobody
+// locks and a half-written event is never handed out. Slots are stored as
+// relaxed atomic words, which keeps those racing copies well-defined.
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+
+struct GameEvent {
+    enum Type : quint8 {
+        RoundStarted,
+        BikeKilled,
+        // a bike came close to another bike's trail and got away; value is the closest distance
+        NearMiss,
+        // bike is the last one standing, -1 if nobody is
+        RoundEnded,
+        // written by whoever runs the match; bike is the winner's slot, -1 if it was lost
+        MatchEnded
+    };
+
+    Type type;
+    quint8 reserved;
+    quint16 round;
+    // the bike the event is about
+    qint16 bike;
+    // the other party: whose trail killed it (-1 for its own trail or a head-on crash), whose trail it passed
+    qint16 other;
+    quint32 tick;
+    float value;
+};
+
+class EventStream {
+public:
+    static constexpr int capacity = 1024;
+
+    struct Reader {
+        quint64 next = 0;
+        qint64 lost = 0;
+    };
+
+    EventStream();
+    EventStream(const EventStream&) = delete;
+    EventStream& operator=(const EventStream&) = delete;
+
+    // writer thread only
+    void push(const GameEvent& e);
+    // a reader that starts after everything written so far
+    Reader reader() const;
+    // copies up to `max` events the reader hasn't seen yet, oldest first; returns how many
+    int read(Reader& r, GameEvent* out, int max) const;
+    quint64 written() const;
+private:
+    static constexpr int slotWords = 2;
+
+    // seq is the event's sequence number plus one; 0 while the slot is being written
+    struct Slot {
+        std::atomic<quint64> seq{0};
+        std::atomic<quint64> words[slotWords];
+    };
+
+    std::array<Slot, capacity> m_slots;
+    std::atomic<quint64> m_written{0};
+};
+
+#endif // EVENTSTREAM_H
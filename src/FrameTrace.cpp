@@ -0,0 +1,171 @@
+#include "FrameTrace.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// zones that were open when a capture stopped may still land in their ring; this many of the
+// oldest slots are left out of the file, since those are the ones such a late write can replace
+const int inFlightSlack = 64;
+// rings start() sets aside for threads that must not allocate, such as the audio callback
+const int spareRings = 2;
+
+struct TraceEvent {
+    const char* name;
+    qint64 start;
+    qint64 duration;
+};
+
+struct ThreadRing {
+    std::vector<TraceEvent> events;
+    std::atomic<quint64> count{0};
+    // count when the current capture started, set under the registry lock
+    quint64 base = 0;
+    int tid = 0;
+    QString name;
+    // set instead of name when a spare ring is adopted; a spare nobody adopted has neither
+    std::atomic<const char*> label{nullptr};
+};
+
+const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+QMutex registryMutex;
+std::vector<std::unique_ptr<ThreadRing>> registry;
+std::array<std::atomic<ThreadRing*>, spareRings> spares{};
+thread_local ThreadRing* threadRing = nullptr;
+
+qint64 nowNs() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count(); }
+
+}
+
+std::atomic<bool> FrameTrace::s_capturing{false};
+
+// the ring outlives the thread
+void FrameTrace::registerThread(const char* name) {
+    if (threadRing) return;
+
+    auto ring = std::make_unique<ThreadRing>();
+
+    ring->events.resize(ringEvents);
+
+    QMutexLocker lock(&registryMutex);
+    QThread* thread = QThread::currentThread();
+    const bool main = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+
+    ring->tid = static_cast<int>(registry.size()) + 1;
+
+    if (name) ring->name = QString(name);
+    else ring->name = main ? QString("main") : !thread->objectName().isEmpty() ? thread->objectName() : QString("thread %1").arg(ring->tid);
+
+    threadRing = ring.get();
+    registry.push_back(std::move(ring));
+}
+
+void FrameTrace::adoptSpareRing(const char* name) {
+    if (threadRing || !capturing()) return;
+
+    for (auto& slot : spares) {
+        ThreadRing* ring = slot.exchange(nullptr, std::memory_order_acq_rel);
+
+        if (!ring) continue;
+
+        ring->label.store(name, std::memory_order_release);
+        threadRing = ring;
+
+        return;
+    }
+}
+
+// zones on threads that never registered are dropped rather than setting up a ring mid-frame
+FrameTrace::Zone::Zone(const char* name) : m_name(capturing() && threadRing ? name : nullptr), m_start(m_name ? nowNs() : 0) {}
+
+FrameTrace::Zone::~Zone() {
+    if (!m_name) return;
+
+    const qint64 end = nowNs();
+    ThreadRing* ring = threadRing;
+    const quint64 n = ring->count.load(std::memory_order_relaxed);
+
+    ring->events[n & (ringEvents - 1)] = {m_name, m_start, end - m_start};
+    ring->count.store(n + 1, std::memory_order_release);
+}
+
+void FrameTrace::start() {
+    QMutexLocker lock(&registryMutex);
+
+    for (const auto& ring : registry) ring->base = ring->count.load(std::memory_order_acquire);
+
+    // refill the spares here, on the caller's thread, so adopting one never allocates
+    for (auto& slot : spares) {
+        if (slot.load(std::memory_order_relaxed)) continue;
+
+        auto ring = std::make_unique<ThreadRing>();
+
+        ring->events.resize(ringEvents);
+        ring->tid = static_cast<int>(registry.size()) + 1;
+        slot.store(ring.get(), std::memory_order_release);
+        registry.push_back(std::move(ring));
+    }
+
+    s_capturing.store(true, std::memory_order_relaxed);
+}
+
+bool FrameTrace::save(const QString& path) {
+    s_capturing.store(false, std::memory_order_relaxed);
+
+    QFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "FrameTrace: cannot write" << path << file.errorString();
+
+        return false;
+    }
+
+    QMutexLocker lock(&registryMutex);
+    QByteArray out("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    qint64 written = 0;
+
+    for (const auto& ring : registry) {
+        const quint64 end = ring->count.load(std::memory_order_acquire), keep = ringEvents - inFlightSlack;
+        const quint64 begin = std::max(ring->base, end > keep ? end - keep : 0);
+        const char* label = ring->label.load(std::memory_order_acquire);
+
+        if (ring->name.isEmpty() && !label) continue;
+
+        out += QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}},\n").arg(ring->tid).arg(label ? QString(label) : ring->name).toUtf8();
+
+        for (quint64 k = begin; k < end; ++k) {
+            const TraceEvent& e = ring->events[k & (ringEvents - 1)];
+
+            out += "{\"name\":\"";
+            out += e.name;
+            out += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            out += QByteArray::number(ring->tid);
+            out += ",\"ts\":";
+            out += QByteArray::number(static_cast<double>(e.start) / 1000.0, 'f', 3);
+            out += ",\"dur\":";
+            out += QByteArray::number(static_cast<double>(e.duration) / 1000.0, 'f', 3);
+            out += "},\n";
+            ++written;
+        }
+
+        // written in pieces so a long capture doesn't sit in memory twice
+        file.write(out);
+        out.clear();
+    }
+
+    // the metadata event ends the array, so no element is followed by a stray comma
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"lohoTRON\"}}\n]}\n";
+    file.write(out);
+    qInfo() << "FrameTrace: wrote" << written << "zones to" << path;
+
+    return file.error() == QFileDevice::NoError;
+}
@@ -0,0 +1,52 @@
+#ifndef FRAMETRACE_H
+#define FRAMETRACE_H
+
+// Scoped timing zones for hunting frame hitches, saved as Chrome Trace Event
+// JSON that chrome://tracing and ui.perfetto.dev open as a timeline.
+// A Zone on the stack times its scope. Every thread writes its own ring of
+// events, set up by registerThread() before its first zone, so recording is
+// two clock reads and a store with no lock and no allocation; zones on threads
+// that never registered are dropped. Real-time threads adopt one of the rings
+// start() sets aside instead. The ring keeps the last `ringEvents` zones per
+// thread (well over 30 s of a busy frame loop).
+// While no capture runs, a zone is a single relaxed load. save() stops the
+// capture and writes what the rings hold; start() begins a fresh one.
+// Zone names must outlive the capture (string literals).
+
+#include <QtGlobal>
+#include <QString>
+#include <atomic>
+
+class FrameTrace {
+public:
+    static constexpr int ringEvents = 1 << 17;
+
+    class Zone {
+    public:
+        explicit Zone(const char* name);
+        ~Zone();
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    private:
+        const char* m_name;
+        qint64 m_start;
+    };
+
+    // sets up the calling thread's ring (3 MB) once; later calls are a thread-local check.
+    // The name labels the thread's track, by default "main" or the QThread's object name
+    static void registerThread(const char* name = nullptr);
+    // for threads that must never allocate or block (the audio callback): while a capture runs, takes
+    // a ring start() set aside, lock-free; otherwise, or once the spares are gone, does nothing.
+    // `name` must be a string literal
+    static void adoptSpareRing(const char* name);
+    static void start();
+    static bool capturing();
+    // stops capturing and writes every recorded zone; false if the file can't be written
+    static bool save(const QString& path);
+private:
+    static std::atomic<bool> s_capturing;
+};
+
+inline bool FrameTrace::capturing() { return s_capturing.load(std::memory_order_relaxed); }
+
+#endif // FRAMETRACE_H
@@ -0,0 +1,441 @@
+#include "GameServer.h"
+#include <QNetworkDatagram>
+#include <QDebug>
+
+namespace {
+
+const qint64 clientTimeoutMs = 5000;
+const qint64 reportIntervalMs = 5000;
+const int maxCatchUpSteps = 5;
+// inputs beyond this are dropped oldest-first so a lag burst doesn't turn into permanent delay
+const size_t maxQueuedInputs = 6;
+const float roundRestartDelay = 2.0f;
+// absolute start index and point count in front of every trail append
+const qint64 appendHeaderBytes = 6;
+
+}
+
+GameServer::GameServer(const Config& config, QObject* parent) : QObject(parent), m_config(config) {
+    m_config.tickRate = std::max(1, m_config.tickRate);
+    m_config.snapshotRate = std::clamp(m_config.snapshotRate, 1, m_config.tickRate);
+    m_socket = new QUdpSocket(this);
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_socket, &QUdpSocket::readyRead, this, &GameServer::onReadyRead);
+    connect(m_tickTimer, &QTimer::timeout, this, &GameServer::onTick);
+    m_sim.setFieldSize(m_config.fieldSize);
+    m_sim.setBotCount(m_config.bots);
+    m_sim.setBotTier(m_config.smartBots ? GameSimulation::TerritoryBots : GameSimulation::ClassicBots);
+
+    if (m_config.persistentWalls) m_sim.setTrailTTL(0.0f);
+
+    m_sim.setHumanSlots(m_config.maxClients);
+}
+
+bool GameServer::start() {
+    if (!m_socket->bind(QHostAddress::Any, m_config.port)) {
+        qWarning() << "GameServer: cannot bind UDP port" << m_config.port << m_socket->errorString();
+
+        return false;
+    }
+
+    startRound();
+    m_clock.start();
+    m_lastStepNs = 0;
+    m_tickTimer->start(std::max(1, 1000 / m_config.tickRate));
+    qInfo() << "GameServer: listening on UDP" << port() << "tick" << m_config.tickRate << "Hz, snapshots" << m_config.snapshotRate << "Hz";
+
+    return true;
+}
+
+quint16 GameServer::port() const { return m_socket->localPort(); }
+
+qint64 GameServer::busyNanoseconds() const { return m_busyNs.load(std::memory_order_relaxed); }
+
+quint32 GameServer::tickCount() const { return m_tickCount.load(std::memory_order_relaxed); }
+
+int GameServer::clientCount() const { return m_clientCount.load(std::memory_order_relaxed); }
+
+void GameServer::startRound() {
+    m_sim.resetRound();
+    m_roundOverTimer = -1.0f;
+
+    // bikes of empty slots stay under AI control until someone joins
+    for (int slot = 0; slot < m_config.maxClients; ++slot) m_sim.setHuman(slot, false);
+
+    for (const Client& c : m_clients) m_sim.setHuman(c.slot, true);
+}
+
+void GameServer::onTick() {
+    QElapsedTimer busy;
+    busy.start();
+    const qint64 stepNs = 1000000000LL / m_config.tickRate;
+    const float dt = 1.0f / static_cast<float>(m_config.tickRate);
+    const qint64 now = m_clock.nsecsElapsed();
+    const int snapshotEvery = std::max(1, m_config.tickRate / m_config.snapshotRate);
+    int steps = 0;
+
+    while (now - m_lastStepNs >= stepNs && steps < maxCatchUpSteps) {
+        m_lastStepNs += stepNs;
+        ++steps;
+        consumeInputs();
+
+        if (m_roundOverTimer >= 0.0f) {
+            m_roundOverTimer -= dt;
+
+            if (m_roundOverTimer < 0.0f) startRound();
+        } else {
+            m_sim.step(dt);
+            m_sim.expireTrails();
+
+            if (m_sim.aliveCount() <= 1) m_roundOverTimer = roundRestartDelay;
+        }
+
+        ++m_tick;
+        captureFrame();
+
+        if (m_tick % snapshotEvery == 0) sendSnapshots();
+    }
+
+    // a stalled host skips ahead instead of fast-forwarding the match
+    if (now - m_lastStepNs >= stepNs * maxCatchUpSteps) m_lastStepNs = now;
+
+    const qint64 nowMs = m_clock.elapsed();
+
+    for (int i = static_cast<int>(m_clients.size()) - 1; i >= 0; --i) {
+        if (nowMs - m_clients[i].lastSeenMs > clientTimeoutMs) {
+            qInfo() << "GameServer: client timed out" << m_clients[i].address.toString() << m_clients[i].port;
+            dropClient(i);
+        }
+    }
+
+    if (nowMs - m_lastReportMs >= reportIntervalMs) {
+        if (m_config.logStats) reportBandwidth();
+
+        m_lastReportMs = nowMs;
+    }
+
+    m_tickCount.store(m_tick, std::memory_order_relaxed);
+    m_clientCount.store(static_cast<int>(m_clients.size()), std::memory_order_relaxed);
+    m_busyNs.fetch_add(busy.nsecsElapsed(), std::memory_order_relaxed);
+}
+
+// one input per client per tick, mirroring how the client advances its prediction;
+// with an empty queue the bike keeps the last turn it was given
+void GameServer::consumeInputs() {
+    for (Client& c : m_clients) {
+        if (c.inputs.empty()) continue;
+
+        const NetProtocol::InputPacket& input = c.inputs.front();
+
+        m_sim.setTurnInput(c.slot, NetProtocol::dequantizeTurn(input.turn));
+        c.lastInputSeq = input.seq;
+        c.inputs.pop_front();
+    }
+}
+
+void GameServer::captureFrame() {
+    using namespace NetProtocol;
+
+    Frame& f = m_frame;
+    const auto& bikes = m_sim.bikes();
+    const auto& trails = m_sim.trails();
+    const float half = m_sim.mapHalfSize(), maxSpeed = m_sim.maxForwardSpeed();
+
+    f.tick = m_tick;
+    f.round = static_cast<quint16>(m_sim.roundId());
+    f.bikes.resize(bikes.size());
+    f.trailHead.resize(bikes.size());
+    f.trailEnd.resize(bikes.size());
+
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        const GameSimulation::Bike& b = bikes[i];
+        BikeState& q = f.bikes[i];
+
+        q.x = quantizeCoord(b.pos.x(), half);
+        q.z = quantizeCoord(b.pos.z(), half);
+        q.yaw = quantizeYaw(b.yaw);
+        q.speed = quantizeSpeed(b.speed, maxSpeed);
+        q.flags = (b.alive ? Alive : 0) | (b.human ? Human : 0);
+        f.trailHead[i] = static_cast<quint32>(m_sim.trailExpired(static_cast<int>(i)));
+        f.trailEnd[i] = f.trailHead[i] + static_cast<quint32>(trails[i].size());
+    }
+}
+
+void GameServer::sendSnapshots() {
+    for (Client& c : m_clients) sendSnapshot(c);
+}
+
+void GameServer::sendSnapshot(Client& c) {
+    using namespace NetProtocol;
+
+    const Frame& cur = m_frame;
+    const size_t n = cur.bikes.size();
+    const auto& bikes = m_sim.bikes();
+    const auto& trails = m_sim.trails();
+    const Frame* base = nullptr;
+
+    if (c.ackTick != noBaseline && m_tick - c.ackTick < static_cast<quint32>(historySize)) {
+        const Frame& candidate = c.views[c.ackTick % historySize];
+
+        if (candidate.tick == c.ackTick && candidate.round == cur.round && candidate.bikes.size() == n) base = &candidate;
+    }
+
+    Frame view;
+
+    if (base) view = *base;
+    else {
+        view.bikes.assign(n, BikeState{});
+        view.trailHead.assign(n, 0);
+        view.trailEnd.assign(n, noBaseline);
+    }
+
+    view.tick = cur.tick;
+    view.round = cur.round;
+
+    if (c.priority.size() != n) c.priority.assign(n, 0.0f);
+
+    // priority: full rate in view and close by, falling off with distance squared outside the area of interest
+    const QVector3D eye = c.slot < static_cast<int>(n) ? bikes[c.slot].pos : QVector3D();
+    const QVector3D look = GameSimulation::forwardFromYaw(c.viewYaw);
+    std::vector<int> urgent;
+    std::vector<bool> near(n, false), selected(n, !base);
+
+    for (size_t i = 0; i < n; ++i) {
+        QVector3D to = bikes[i].pos - eye;
+        to.setY(0.0f);
+
+        const float d2 = to.lengthSquared(), r2 = m_config.aoiRadius * m_config.aoiRadius;
+        const bool inView = d2 < 1.0f || QVector3D::dotProduct(to, look) > 0.0f;
+
+        near[i] = d2 <= r2;
+        c.priority[i] += (near[i] ? 1.0f : std::max(0.05f, r2 / d2)) * (inView ? 1.0f : 0.4f);
+
+        if (static_cast<int>(i) == c.slot) selected[i] = true;
+        else if (c.priority[i] >= 1.0f) urgent.push_back(static_cast<int>(i));
+    }
+
+    if (base) {
+        const size_t budget = std::min(urgent.size(), static_cast<size_t>(std::max(0, m_config.bikeBudget)));
+
+        std::partial_sort(urgent.begin(), urgent.begin() + budget, urgent.end(), [&c](int a, int b) { return c.priority[a] > c.priority[b]; });
+
+        for (size_t k = 0; k < budget; ++k) selected[urgent[k]] = true;
+    }
+
+    std::vector<TrailAppend> appends(n);
+    std::vector<TrailSummary> summaries(n);
+    std::vector<int> exact;
+
+    // a few points standing in for the whole trail; returns their wire size
+    auto summarise = [&](int i) {
+        const auto& trail = trails[i];
+        const size_t points = std::min(trail.size(), static_cast<size_t>(std::max(2, m_config.summaryPoints)));
+
+        for (size_t k = 0; k < points; ++k) {
+            const GameSimulation::TrailPoint& p = trail[points > 1 ? k * (trail.size() - 1) / (points - 1) : 0];
+
+            summaries[i].cells.push_back({p.x, p.z});
+        }
+
+        view.trailEnd[i] = noBaseline;
+
+        return points > 0 ? static_cast<qint64>(1 + points * sizeof(TrailCell)) : 0;
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!selected[i]) continue;
+
+        c.priority[i] = 0.0f;
+        view.bikes[i] = cur.bikes[i];
+        view.trailHead[i] = cur.trailHead[i];
+
+        // the client's own trail goes first, so the others never starve it
+        if (static_cast<int>(i) == c.slot) exact.insert(exact.begin(), static_cast<int>(i));
+        else if (near[i]) exact.push_back(static_cast<int>(i));
+        else summarise(static_cast<int>(i));
+    }
+
+    // trail points only get the room the rest leaves in one unfragmented datagram; what doesn't fit
+    // (a whole persistent wall after joining, say) follows in the next snapshots
+    qint64 room = m_config.maxSnapshotBytes - encodeSnapshot(view, base, c.lastInputSeq, appends, summaries).size();
+
+    for (int i : exact) {
+        const quint32 head = cur.trailHead[i];
+        const quint32 from = view.trailEnd[i] == noBaseline ? head : std::max(view.trailEnd[i], head);
+        const quint32 cells = static_cast<quint32>(std::clamp<qint64>((room - appendHeaderBytes) / static_cast<qint64>(sizeof(TrailCell)), 0, cur.trailEnd[i] - from));
+
+        // nothing fits and the client holds none of it yet: a summary until the budget gets there
+        if (cells == 0 && from < cur.trailEnd[i] && view.trailEnd[i] == noBaseline) {
+            room -= summarise(i);
+
+            continue;
+        }
+
+        TrailAppend& a = appends[i];
+
+        a.from = from;
+
+        // trail points are already on the wire grid
+        for (quint32 idx = from; idx < from + cells; ++idx) {
+            const GameSimulation::TrailPoint& p = trails[i][idx - head];
+
+            a.cells.push_back({p.x, p.z});
+        }
+
+        if (cells > 0) room -= appendHeaderBytes + cells * static_cast<qint64>(sizeof(TrailCell));
+
+        view.trailEnd[i] = from + cells;
+    }
+
+    const qint64 sent = m_socket->writeDatagram(encodeSnapshot(view, base, c.lastInputSeq, appends, summaries), c.address, c.port);
+
+    if (sent > 0) c.bytesSent += sent;
+
+    c.views[m_tick % historySize] = std::move(view);
+}
+
+void GameServer::onReadyRead() {
+    using namespace NetProtocol;
+
+    QElapsedTimer busy;
+    busy.start();
+
+    while (m_socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_socket->receiveDatagram();
+        QByteArray data = datagram.data();
+        QDataStream in(data);
+        PacketType type;
+
+        if (!readHeader(in, type)) continue;
+
+        const QHostAddress address = datagram.senderAddress();
+        const quint16 port = static_cast<quint16>(datagram.senderPort());
+        int idx = -1;
+        Client* client = findClient(address, port, &idx);
+
+        if (client) client->lastSeenMs = m_clock.elapsed();
+
+        switch (type) {
+        case Hello:
+            handleHello(address, port, in);
+            break;
+        case Input:
+            if (client) handleInput(*client, in);
+
+            break;
+        case Bye:
+            if (client) dropClient(idx);
+
+            break;
+        default:
+            break;
+        }
+    }
+
+    m_busyNs.fetch_add(busy.nsecsElapsed(), std::memory_order_relaxed);
+}
+
+void GameServer::handleHello(const QHostAddress& address, quint16 port, QDataStream& in) {
+    using namespace NetProtocol;
+
+    HelloPacket hello;
+
+    if (!decodeHello(in, hello)) return;
+
+    Client* client = findClient(address, port);
+
+    if (!client) {
+        int slot = freeSlot();
+
+        if (slot < 0) return;
+
+        Client c;
+        c.address = address;
+        c.port = port;
+        c.slot = slot;
+        c.lastSeenMs = m_clock.elapsed();
+        m_clients.push_back(c);
+        client = &m_clients.back();
+        m_sim.setHuman(slot, true);
+        qInfo() << "GameServer:" << hello.name << "joined from" << address.toString() << port << "slot" << slot;
+    }
+
+    WelcomePacket welcome;
+    welcome.slot = static_cast<quint16>(client->slot);
+    welcome.fieldSize = static_cast<quint16>(m_sim.gridSize());
+    welcome.tickRate = static_cast<quint16>(m_config.tickRate);
+    welcome.mapHalfSize = m_sim.mapHalfSize();
+    welcome.maxSpeed = m_sim.maxForwardSpeed();
+    const qint64 sent = m_socket->writeDatagram(encodeWelcome(welcome), address, port);
+
+    if (sent > 0) client->bytesSent += sent;
+}
+
+void GameServer::handleInput(Client& client, QDataStream& in) {
+    using namespace NetProtocol;
+
+    InputPacket input;
+
+    if (!decodeInput(in, input)) return;
+
+    // acks only move forward; reordered datagrams keep the newer baseline
+    if (input.ackTick != noBaseline && (client.ackTick == noBaseline || input.ackTick > client.ackTick)) client.ackTick = input.ackTick;
+
+    if (input.seq <= client.lastReceivedSeq) return;
+
+    client.lastReceivedSeq = input.seq;
+    client.viewYaw = dequantizeYaw(input.viewYaw);
+    client.inputs.push_back(input);
+
+    while (client.inputs.size() > maxQueuedInputs) client.inputs.pop_front();
+}
+
+void GameServer::dropClient(int idx) {
+    if (idx < 0 || idx >= static_cast<int>(m_clients.size())) return;
+
+    m_sim.setHuman(m_clients[idx].slot, false);
+    m_clients.erase(m_clients.begin() + idx);
+}
+
+GameServer::Client* GameServer::findClient(const QHostAddress& address, quint16 port, int* idx) {
+    for (size_t i = 0; i < m_clients.size(); ++i) {
+        if (m_clients[i].port == port && m_clients[i].address.isEqual(address)) {
+            if (idx) *idx = static_cast<int>(i);
+
+            return &m_clients[i];
+        }
+    }
+
+    return nullptr;
+}
+
+int GameServer::freeSlot() const {
+    for (int slot = 0; slot < m_config.maxClients; ++slot) {
+        bool taken = std::any_of(m_clients.begin(), m_clients.end(), [slot](const Client& c) { return c.slot == slot; });
+
+        if (!taken) return slot;
+    }
+
+    return -1;
+}
+
+void GameServer::reportBandwidth() {
+    if (m_clients.empty()) return;
+
+    const double seconds = reportIntervalMs / 1000.0;
+    qint64 total = 0;
+
+    for (Client& c : m_clients) {
+        total += c.bytesSent;
+        c.bytesSent = 0;
+    }
+
+    const GameSimulation::AiStats& ai = m_sim.aiStats();
+    const RoundArena& arena = m_sim.roundArena();
+
+    qInfo().nospace() << "GameServer: " << m_clients.size() << " clients, tick " << m_tick << ", "
+        << (total / seconds / m_clients.size() / 1024.0) << " KiB/s per client, AI " << ai.thought << "/" << ai.due
+        << " thinks in " << ai.nanoseconds / 1000 << " us, round arena " << arena.highWater() / 1024 << "/"
+        << arena.capacity() / 1024 << " KiB high water, " << arena.totalOverflows() << " overflows";
+}
@@ -0,0 +1,106 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+// Headless match host: runs GameSimulation at a fixed tick and replicates it to
+// UDP clients with quantized, delta-compressed snapshots (see NetProtocol.h).
+// Client slots that nobody occupies are driven by the bot AI.
+// Each client only hears about what matters to it: bikes accumulate priority by
+// distance and by whether they are in front of the client's camera, a fixed
+// number of the most urgent ones go into each snapshot, and trails beyond the
+// area of interest are sent as coarse summaries. The server remembers exactly
+// what every client was sent, so deltas stay correct for bikes it skipped.
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include "GameSimulation.h"
+#include "NetProtocol.h"
+
+class GameServer : public QObject {
+    Q_OBJECT
+public:
+    struct Config {
+        quint16 port = 7777;
+        int maxClients = 8;
+        int bots = 8;
+        bool smartBots = false;
+        // classic mode: trails stay up for the whole round
+        bool persistentWalls = false;
+        int fieldSize = 150;
+        int tickRate = 60;
+        int snapshotRate = 20;
+        // world units around the client's bike that get full trail detail
+        float aoiRadius = 90.0f;
+        // bike updates per snapshot besides the client's own
+        int bikeBudget = 24;
+        int summaryPoints = 8;
+        // snapshot size trail points are budgeted against: below a 1500-byte MTU after IP and UDP headers,
+        // so snapshots are never fragmented; longer trails catch up over the next snapshots
+        int maxSnapshotBytes = 1200;
+        // periodic bandwidth line in the log; MatchHost prints its own summary instead
+        bool logStats = true;
+    };
+
+    explicit GameServer(const Config& config, QObject* parent = nullptr);
+    bool start();
+    quint16 port() const;
+    // safe to read from any thread: time spent inside this instance's handlers, ticks run, connected clients
+    qint64 busyNanoseconds() const;
+    quint32 tickCount() const;
+    int clientCount() const;
+private slots:
+    void onReadyRead();
+    void onTick();
+private:
+    struct Client {
+        QHostAddress address;
+        quint16 port = 0;
+        int slot = -1;
+        // newest input applied to the simulation; echoed back so the client can replay the rest
+        quint32 lastInputSeq = 0;
+        quint32 lastReceivedSeq = 0;
+        std::deque<NetProtocol::InputPacket> inputs;
+        quint32 ackTick = NetProtocol::noBaseline;
+        qint64 lastSeenMs = 0;
+        qint64 bytesSent = 0;
+        float viewYaw = 0.0f;
+        std::vector<float> priority;
+        // what this client holds after each snapshot we sent it; trailEnd is noBaseline for coarse trails
+        std::array<NetProtocol::Frame, NetProtocol::historySize> views;
+    };
+
+    void handleHello(const QHostAddress& address, quint16 port, QDataStream& in);
+    void handleInput(Client& client, QDataStream& in);
+    void dropClient(int idx);
+    Client* findClient(const QHostAddress& address, quint16 port, int* idx = nullptr);
+    int freeSlot() const;
+    void startRound();
+    void consumeInputs();
+    void captureFrame();
+    void sendSnapshots();
+    void sendSnapshot(Client& c);
+    void reportBandwidth();
+
+    Config m_config;
+    QUdpSocket* m_socket;
+    QTimer* m_tickTimer;
+    QElapsedTimer m_clock;
+    qint64 m_lastStepNs = 0;
+    qint64 m_lastReportMs = 0;
+    GameSimulation m_sim;
+    std::vector<Client> m_clients;
+    NetProtocol::Frame m_frame;
+    quint32 m_tick = 0;
+    float m_roundOverTimer = -1.0f;
+    std::atomic<qint64> m_busyNs{0};
+    std::atomic<quint32> m_tickCount{0};
+    std::atomic<int> m_clientCount{0};
+};
+
+#endif // GAMESERVER_H
@@ -0,0 +1,907 @@
+#include "GameSimulation.h"
+#include <cstring>
+#include <chrono>
+
+namespace {
+
+const float pi = 3.14159265358979f;
+const float halfPi = 1.57079632679490f;
+
+// odd Taylor series to x^11 after folding into [-pi/2, pi/2]; only + and * so every IEEE float
+// implementation agrees, unlike libm sin/cos
+float detSin(float x) {
+    x = GameSimulation::wrapPi(x);
+
+    if (x > halfPi) x = pi - x;
+    else if (x < -halfPi) x = -pi - x;
+
+    const float x2 = x * x;
+
+    return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+}
+
+float detCos(float x) { return detSin(x + halfPi); }
+
+// a deferred bot runs regardless of the budget once it is this many ticks late
+const int maxAiLag = 8;
+const int maxAiInterval = 6;
+// territory bots: look-ahead per candidate turn and depth of the Voronoi race, in cells
+const int territoryLookAhead = 6;
+const int territoryDepth = 24;
+// classic bots: fan rays and the "way ahead is blocked" test see at most this many cells ahead
+const float fanHorizon = 20.0f;
+// ...and count as cornered when even the longest ray ends within this many cells
+const float trappedCells = 6.0f;
+// path planner nodes per tick, shared by every search, and the furthest a hunter leads the player
+const int planNodeBudget = 4096;
+const float maxInterceptLead = 30.0f;
+// a bike can't hit its own trail points younger than this
+const quint16 ownTrailGraceMs = 100;
+// passing another bike's trail this close (world units, centre to point) without hitting it is a near miss
+const float nearMissDist = 1.6f;
+
+const quint64 fnvOffset = 1469598103934665603ull;
+const quint64 fnvPrime = 1099511628211ull;
+
+quint64 fnv(quint64 h, const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+
+    for (size_t i = 0; i < size; ++i) h = (h ^ p[i]) * fnvPrime;
+
+    return h;
+}
+
+// swaps in an empty vector on the same resource, so nothing points into the arena once it rewinds
+template <typename T>
+void dropStorage(std::pmr::vector<T>& v) { std::pmr::vector<T>(v.get_allocator()).swap(v); }
+
+quint64 fnvFloat(quint64 h, float v) {
+    quint32 bits;
+    std::memcpy(&bits, &v, sizeof bits);
+
+    return fnv(h, &bits, sizeof bits);
+}
+
+}
+
+GameSimulation::GameSimulation()
+    : m_arena(std::make_unique<RoundArena>()), m_bikes(m_arena.get()), m_bikeTrails(m_arena.get()), m_trailExpired(m_arena.get()),
+      m_killed(m_arena.get()), m_killedBy(m_arena.get()) {
+    m_gridSize = 100;
+    m_cellSize = 2.0f;
+    m_mapHalfSize = 0.5f * m_cellSize * static_cast<float>(m_gridSize);
+    m_botCount = 3;
+    m_humanSlots = 1;
+    m_roundId = 0;
+    m_humanColor = QVector3D(0.0f, 0.8f, 1.0f);
+    m_maxForwardSpeed = 40.0f;
+    m_acceleration = 40.0f;
+    m_friction = 18.0f;
+    m_turnSpeed = 2.8f;
+    m_trailTTL = 1.0f;
+    m_trailMinDist = 0.35f;
+    m_wallCapacity = 1024;
+    m_time = 0.0f;
+    m_timeMs = 0;
+    m_alive = 0;
+    m_roundEnded = false;
+    m_events = nullptr;
+    m_seed = 0;
+    m_seeded = false;
+    m_rng = 1;
+    m_tick = 0;
+    m_checksum = fnvOffset;
+    m_aiBudgetNs = 2000000;
+    m_aiThinkBudget = 64;
+    m_botTier = ClassicBots;
+}
+
+void GameSimulation::setFieldSize(int n) {
+    m_gridSize = std::max(10, n);
+    m_mapHalfSize = 0.5f * m_cellSize * static_cast<float>(m_gridSize);
+}
+
+void GameSimulation::setBotCount(int n) { m_botCount = std::max(0, n); }
+
+void GameSimulation::setHumanSlots(int n) { m_humanSlots = std::max(0, n); }
+
+void GameSimulation::setHumanColor(const QVector3D& color) { m_humanColor = color; }
+
+// point ages wrap after 65.5 s, so that is as long as a fading trail can last
+void GameSimulation::setTrailTTL(float seconds) { m_trailTTL = std::clamp(seconds, 0.0f, 65.0f); }
+
+void GameSimulation::setSeed(quint64 seed) {
+    m_seed = seed;
+    m_seeded = true;
+}
+
+void GameSimulation::setAiBudget(int microseconds, int thinks) {
+    m_aiBudgetNs = static_cast<qint64>(std::max(0, microseconds)) * 1000;
+    m_aiThinkBudget = std::max(1, thinks);
+}
+
+void GameSimulation::setBotTier(BotTier tier) { m_botTier = tier; }
+
+GameSimulation::BotTier GameSimulation::botTier() const { return m_botTier; }
+
+void GameSimulation::setBotParams(const BotParams& params) {
+    m_botParams = params;
+    m_bikeParams.clear();
+}
+
+void GameSimulation::setBotParams(int idx, const BotParams& params) {
+    if (idx < 0) return;
+
+    if (idx >= static_cast<int>(m_bikeParams.size())) m_bikeParams.resize(idx + 1, m_botParams);
+
+    m_bikeParams[idx] = params;
+}
+
+const GameSimulation::BotParams& GameSimulation::botParams(int idx) const {
+    return idx >= 0 && idx < static_cast<int>(m_bikeParams.size()) ? m_bikeParams[idx] : m_botParams;
+}
+
+// xorshift32; the state never reaches zero
+float GameSimulation::random01() {
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 17;
+    m_rng ^= m_rng << 5;
+
+    return static_cast<float>(m_rng >> 8) * (1.0f / 16777216.0f);
+}
+
+void GameSimulation::setHuman(int idx, bool human) {
+    if (idx < 0 || idx >= static_cast<int>(m_bikes.size())) return;
+
+    m_bikes[idx].human = human;
+    m_bikes[idx].turnInput = 0.0f;
+}
+
+void GameSimulation::setTurnInput(int idx, float turn) {
+    if (idx < 0 || idx >= static_cast<int>(m_bikes.size())) return;
+
+    m_bikes[idx].turnInput = std::max(-1.0f, std::min(1.0f, turn));
+}
+
+void GameSimulation::resetRound() {
+    int total = m_humanSlots + m_botCount;
+
+    ++m_roundId;
+
+    // without expiry a trail grows all round, so it reserves what the longest one so far needed, plus a quarter
+    for (const Trail& trail : m_bikeTrails) m_wallCapacity = std::max(m_wallCapacity, trail.size() + trail.size() / 4);
+
+    // a trail holds at most one point per m_trailMinDist travelled within its lifetime
+    const size_t trailCapacity = m_trailTTL > 0.0f ? static_cast<size_t>(std::ceil(m_maxForwardSpeed * m_trailTTL / m_trailMinDist)) + 2 : m_wallCapacity;
+    const size_t perBike = sizeof(Bike) + sizeof(Trail) + trailCapacity * sizeof(TrailPoint) + 3 * sizeof(int) + 64;
+
+    dropStorage(m_bikes);
+    dropStorage(m_bikeTrails);
+    dropStorage(m_trailExpired);
+    dropStorage(m_killed);
+    dropStorage(m_killedBy);
+    m_arena->reset(static_cast<size_t>(total) * perBike);
+
+    m_bikes.resize(total);
+    m_bikeTrails.resize(total);
+
+    for (Trail& trail : m_bikeTrails) trail.reserve(trailCapacity);
+
+    m_trailExpired.assign(total, 0);
+    m_killed.reserve(total);
+    m_killedBy.assign(total, -1);
+    m_time = 0.0f;
+    m_timeMs = 0;
+    m_tick = 0;
+    m_checksum = fnvOffset;
+    m_alive = total;
+    m_roundEnded = false;
+    m_nearMiss.assign(total, TrailGrid::Closest{0});
+
+    quint64 seed = m_seeded ? m_seed + static_cast<quint64>(m_roundId) * 0x9E3779B97F4A7C15ull : static_cast<quint64>(std::time(nullptr));
+
+    m_rng = static_cast<quint32>(seed ^ (seed >> 32));
+
+    if (m_rng == 0) m_rng = 0x6C078965u;
+
+    m_danger.reset(m_gridSize, m_gridSize);
+    m_trailGrid.reset(m_gridSize, m_gridSize);
+    m_planner.reset(m_gridSize, m_gridSize);
+
+    if (m_bikes.empty()) return;
+
+    QVector3D colors[6] = {
+        QVector3D(0.243f, 0.337f, 0.133f),
+        QVector3D(0.141f, 0.431f, 0.725f),
+        QVector3D(0.306f, 0.008f, 0.314f),
+        QVector3D(0.918f, 0.604f, 0.698f),
+        QVector3D(0.22f, 0.302f, 0.282f),
+        QVector3D(0.8f, 0.247f, 0.047f)
+    };
+
+    float spawnRadius = m_mapHalfSize * 0.75f;
+
+    for (int i = 0; i < total; ++i) {
+        Bike& b = m_bikes[i];
+        float baseAngle = (static_cast<float>(i) / total) * 2.0f * static_cast<float>(M_PI);
+        float jitter = (random01() - 0.5f) * 0.4f;
+        float angle = baseAngle + jitter, radiusJitter = 0.15f * spawnRadius;
+        float r = spawnRadius - radiusJitter + random01() * radiusJitter;
+        float x = detCos(angle) * r, z = detSin(angle) * r;
+
+        // the first slot starts on the centre line facing the arena, everyone else on the spawn ring
+        if (i == 0) {
+            b.pos = QVector3D(0, 0.0f, z);
+            b.yaw = static_cast<float>(M_PI) - angle;
+        } else {
+            b.pos = QVector3D(x, 0.0f, z);
+            b.yaw = -angle + static_cast<float>(M_PI);
+        }
+
+        b.speed = 0.0f;
+        b.lean = 0.0f;
+        b.human = i < m_humanSlots;
+        b.color = (i == 0) ? m_humanColor : b.human ? colors[i % 5] : colors[5];
+        b.alive = true;
+        b.prevPos = b.pos;
+        b.currPos = b.pos;
+        b.aiTurnTimer = 0.5f + random01();
+        b.aiTurnDir = 0.0f;
+        b.turnInput = 0.0f;
+        b.aiElapsed = 0.0f;
+        b.aiLag = 0;
+        b.aiInterval = 1;
+        b.aiAvoiding = false;
+
+        addTrailPoint(i);
+    }
+
+    m_danger.flush();
+
+    if (m_events) m_events->push(makeEvent(GameEvent::RoundStarted, -1, -1, 0.0f));
+}
+
+void GameSimulation::killBike(int idx) {
+    if (idx < 0 || idx >= static_cast<int>(m_bikes.size())) return;
+
+    Bike& b = m_bikes[idx];
+
+    if (!b.alive) return;
+
+    b.alive = false;
+    --m_alive;
+    m_killed.push_back(idx);
+}
+
+void GameSimulation::setEventStream(EventStream* events) { m_events = events; }
+
+GameEvent GameSimulation::makeEvent(GameEvent::Type type, int bike, int other, float value) const {
+    GameEvent e;
+
+    e.type = type;
+    e.reserved = 0;
+    e.round = static_cast<quint16>(m_roundId);
+    e.bike = static_cast<qint16>(bike);
+    e.other = static_cast<qint16>(other);
+    e.tick = m_tick;
+    e.value = value;
+
+    return e;
+}
+
+// a near miss is reported once the bike has left the trail's reach, with the closest it got
+void GameSimulation::trackNearMiss(int idx, const TrailGrid::Closest& closest) {
+    TrailGrid::Closest& near = m_nearMiss[idx];
+
+    if (closest.owner >= 0) {
+        if (near.owner < 0 || closest.distance2 < near.distance2) near = closest;
+
+        return;
+    }
+
+    if (near.owner < 0) return;
+
+    const float distance = std::sqrt(static_cast<float>(near.distance2)) / trailStepsPerUnit();
+
+    m_events->push(makeEvent(GameEvent::NearMiss, idx, near.owner, distance));
+    near.owner = -1;
+}
+
+void GameSimulation::publishEvents() {
+    for (int idx : m_killed) m_events->push(makeEvent(GameEvent::BikeKilled, idx, m_killedBy[idx], 0.0f));
+
+    if (m_roundEnded || m_alive > 1) return;
+
+    int winner = -1;
+
+    for (size_t i = 0; i < m_bikes.size() && winner < 0; ++i) {
+        if (m_bikes[i].alive) winner = static_cast<int>(i);
+    }
+
+    m_roundEnded = true;
+    m_events->push(makeEvent(GameEvent::RoundEnded, winner, -1, m_time));
+}
+
+void GameSimulation::updateBot(Bike& b, int idx, float dt) {
+    const BotParams& params = botParams(idx);
+    const float lookAheadDist = params.lookAheadDist, avoidThreshold = params.avoidThreshold, attackDist2 = params.attackDist2, minDotAttack = params.minDotAttack;
+    const Bike& player = m_bikes[0];
+    QVector3D forwardDir = forwardFromYaw(b.yaw);
+    QVector3D rightDir(forwardDir.z(), 0, -forwardDir.x());
+
+    // fan of headings across the front half; the centre ray is straight ahead
+    const int rays = 9, centre = rays / 2;
+    const float horizon = std::min(lookAheadDist, fanHorizon * m_cellSize);
+    float freeDist[maxFanRays];
+
+    castFan(b.pos, b.yaw, rays, halfPi, avoidThreshold / m_cellSize, horizon, freeDist);
+
+    const bool needAvoid = freeDist[centre] < horizon;
+    float avoidTurn = 0.0f;
+
+    if (needAvoid) {
+        int best = centre;
+        float bestScore = freeDist[centre];
+
+        // the longest ray wins; straighter headings break near-ties
+        for (int i = 0; i < rays; ++i) {
+            const float score = freeDist[i] - 0.5f * m_cellSize * static_cast<float>(std::abs(i - centre));
+
+            if (score > bestScore) {
+                bestScore = score;
+                best = i;
+            }
+        }
+
+        // cornered: among the rays not much shorter than the best, take the one closest to a route out
+        std::pair<int, int> open, waypoint;
+
+        if (freeDist[best] < trappedCells * m_cellSize && m_planner.openRegion(m_danger, cellOf(b.pos), 2, open) && m_planner.route(m_danger, cellOf(b.pos), open, m_tick, waypoint)) {
+            const QVector3D to = cellCentre(waypoint) - b.pos;
+            float bestDot = -2.0f;
+            const float longest = freeDist[best];
+
+            for (int i = 0; i < rays; ++i) {
+                const float heading = b.yaw + halfPi * (2.0f * static_cast<float>(i) / static_cast<float>(rays - 1) - 1.0f);
+                const float dot = QVector3D::dotProduct(forwardFromYaw(heading), to);
+
+                if (freeDist[i] >= 0.75f * longest && dot > bestDot) {
+                    bestDot = dot;
+                    best = i;
+                }
+            }
+        }
+
+        // ray headings grow with the index and positive turn input grows the yaw
+        avoidTurn = best > centre ? 1.0f : best < centre ? -1.0f : 0.0f;
+    }
+
+    b.aiAvoiding = needAvoid;
+
+    if (needAvoid) b.turnInput = avoidTurn;
+    else {
+        QVector3D toPlayer = player.pos - b.pos;
+        toPlayer.setY(0);
+
+        float dist2 = toPlayer.lengthSquared();
+
+        if (dist2 > 0.0001f) toPlayer *= 1.0f / std::sqrt(dist2);
+
+        float dotForward = QVector3D::dotProduct(forwardDir, toPlayer);
+        std::pair<int, int> waypoint;
+
+        if (dist2 <= attackDist2 && dotForward > minDotAttack) {
+            float side = QVector3D::dotProduct(toPlayer, rightDir);
+
+            b.turnInput = (side > 0) ? -1.0f : 1.0f;
+            b.turnInput *= 0.4f + 0.4f * random01();
+        } else if (idx != 0 && player.alive && dist2 <= params.huntDist * params.huntDist && m_planner.route(m_danger, cellOf(b.pos), interceptCell(player, std::sqrt(dist2)), m_tick, waypoint)) {
+            b.turnInput = steerTowards(b, waypoint);
+        } else {
+            b.aiTurnTimer -= dt;
+
+            if (b.aiTurnTimer <= 0.0f) {
+                b.aiTurnTimer = params.wanderMin + random01() * params.wanderRange;
+
+                float r = random01();
+
+                if (r < params.wanderTurnChance) b.aiTurnDir = -1.0f;
+                else if (r > 1.0f - params.wanderTurnChance) b.aiTurnDir = 1.0f;
+                else b.aiTurnDir = 0.0f;
+            }
+
+            b.turnInput = b.aiTurnDir;
+        }
+    }
+}
+
+// all rays advance together over structure-of-arrays state; each hop is the field's free distance
+// past the clearance, stretched across empty blocks by reach(), so a ray takes a handful of lookups
+// instead of one per cell
+void GameSimulation::castFan(const QVector3D& origin, float yaw, int rays, float halfAngle, float clearance, float range, float* out) const {
+    const int n = std::clamp(rays, 1, maxFanRays);
+    const float inv = 1.0f / m_cellSize;
+    // start past the bike's own fresh trail
+    const float start = (std::floor(clearance) + 2.0f) * m_cellSize;
+    float dx[maxFanRays], dz[maxFanRays], t[maxFanRays];
+    bool done[maxFanRays];
+    int live = n;
+
+    for (int i = 0; i < n; ++i) {
+        const float heading = n > 1 ? yaw + halfAngle * (2.0f * static_cast<float>(i) / static_cast<float>(n - 1) - 1.0f) : yaw;
+        const QVector3D dir = forwardFromYaw(heading);
+
+        dx[i] = dir.x();
+        dz[i] = dir.z();
+        t[i] = start;
+        out[i] = range;
+        done[i] = start > range;
+        live -= done[i] ? 1 : 0;
+    }
+
+    while (live > 0) {
+        for (int i = 0; i < n; ++i) {
+            if (done[i]) continue;
+
+            const int cx = static_cast<int>(std::floor((origin.x() + dx[i] * t[i] + m_mapHalfSize) * inv));
+            const int cz = static_cast<int>(std::floor((origin.z() + dz[i] * t[i] + m_mapHalfSize) * inv));
+            const float free = static_cast<float>(m_danger.reach(cx, cz));
+
+            if (free <= clearance) {
+                out[i] = t[i];
+                done[i] = true;
+                --live;
+            } else {
+                t[i] += std::max(1.0f, free - clearance) * m_cellSize;
+
+                if (t[i] > range) {
+                    done[i] = true;
+                    --live;
+                }
+            }
+        }
+    }
+}
+
+float GameSimulation::trailStepsPerUnit() const { return 32767.0f / m_mapHalfSize; }
+
+// rounds like NetProtocol's quantizeCoord, so the server can send points as they are
+GameSimulation::TrailPoint GameSimulation::packTrailPoint(const QVector3D& p) const {
+    TrailPoint tp;
+
+    tp.x = static_cast<qint16>(std::lround(std::clamp(p.x() / m_mapHalfSize, -1.0f, 1.0f) * 32767.0f));
+    tp.z = static_cast<qint16>(std::lround(std::clamp(p.z() / m_mapHalfSize, -1.0f, 1.0f) * 32767.0f));
+    tp.ms = m_timeMs;
+
+    return tp;
+}
+
+// the cell comes from the packed point, so expiry finds it again in the same cell
+void GameSimulation::addTrailPoint(int idx) {
+    const TrailPoint tp = packTrailPoint(m_bikes[idx].pos);
+    const auto c = cellOf(trailPos(tp));
+
+    m_bikeTrails[idx].push_back(tp);
+    m_danger.addPoint(c.first, c.second);
+    m_trailGrid.add(c.first, c.second, tp, idx);
+}
+
+QVector3D GameSimulation::trailPos(const TrailPoint& tp) const {
+    const float unit = m_mapHalfSize / 32767.0f;
+
+    return QVector3D(static_cast<float>(tp.x) * unit, 0.0f, static_cast<float>(tp.z) * unit);
+}
+
+float GameSimulation::trailAge(const TrailPoint& tp) const { return static_cast<float>(static_cast<quint16>(m_timeMs - tp.ms)) * 0.001f; }
+
+QVector3D GameSimulation::cellCentre(const std::pair<int, int>& c) const {
+    return QVector3D((static_cast<float>(c.first) + 0.5f) * m_cellSize - m_mapHalfSize, 0.0f, (static_cast<float>(c.second) + 0.5f) * m_cellSize - m_mapHalfSize);
+}
+
+// where the target will be by the time we get there, if it keeps going straight
+std::pair<int, int> GameSimulation::interceptCell(const Bike& target, float dist) const {
+    const float lead = std::min(maxInterceptLead, dist * target.speed / std::max(1.0f, m_maxForwardSpeed));
+    const float border = m_mapHalfSize - m_cellSize * 2.0f;
+    QVector3D p = target.pos + forwardFromYaw(target.yaw) * lead;
+
+    p.setX(qBound(-border, p.x(), border));
+    p.setZ(qBound(-border, p.z(), border));
+
+    return cellOf(p);
+}
+
+// full turn towards a cell, none once it is within a few degrees of straight ahead
+float GameSimulation::steerTowards(const Bike& b, const std::pair<int, int>& cell) const {
+    const QVector3D forward = forwardFromYaw(b.yaw);
+    // where the heading swings to under positive turn input
+    const QVector3D turning(forward.z(), 0.0f, -forward.x());
+    QVector3D to = cellCentre(cell) - b.pos;
+
+    to.setY(0.0f);
+
+    const float len = to.length();
+
+    if (len < 0.0001f || QVector3D::dotProduct(forward, to) > 0.995f * len) return 0.0f;
+
+    return QVector3D::dotProduct(to, turning) > 0.0f ? 1.0f : -1.0f;
+}
+
+std::pair<int, int> GameSimulation::cellOf(const QVector3D& p) const {
+    const float inv = 1.0f / m_cellSize;
+
+    return std::make_pair(static_cast<int>(std::floor((p.x() + m_mapHalfSize) * inv)), static_cast<int>(std::floor((p.z() + m_mapHalfSize) * inv)));
+}
+
+void GameSimulation::rebuildOccupancy() {
+    if (m_occupancy.width() != m_gridSize) m_occupancy.resize(m_gridSize, m_gridSize);
+    else m_occupancy.clear();
+
+    // the danger field already counts trail points per cell; walking its walls doesn't grow with trail length
+    m_danger.forEachWall([this](int x, int y) { m_occupancy.set(x, y); });
+
+    m_bikeCells.resize(m_bikes.size());
+
+    for (size_t i = 0; i < m_bikes.size(); ++i) m_bikeCells[i] = cellOf(m_bikes[i].pos);
+}
+
+// tries hard left, straight and hard right; a path into a wall scores by how late it hits
+void GameSimulation::updateBotTerritory(Bike& b, int idx) {
+    const float stepDt = m_cellSize / std::max(1.0f, m_maxForwardSpeed);
+    const std::pair<int, int> start = m_bikeCells[idx];
+    std::vector<std::pair<int, int>>& rivals = m_rivals;
+
+    rivals.clear();
+
+    for (size_t j = 0; j < m_bikes.size(); ++j) {
+        if (static_cast<int>(j) != idx && m_bikes[j].alive) rivals.push_back(m_bikeCells[j]);
+    }
+
+    const float turns[3] = {0.0f, -1.0f, 1.0f};
+    float bestTurn = 0.0f;
+    int bestScore = -1000000;
+    bool straightBlocked = false;
+
+    for (float turn : turns) {
+        Bike probe = b;
+        std::pair<int, int> cell = start;
+        int score = 0;
+
+        probe.turnInput = turn;
+
+        for (int k = 0; k < territoryLookAhead; ++k) {
+            advanceBike(probe, stepDt);
+            cell = cellOf(probe.pos);
+
+            if (cell != start && m_occupancy.blocked(cell.first, cell.second)) {
+                score = -1000 + k;
+                break;
+            }
+        }
+
+        if (score == 0) score = m_occupancy.voronoi(cell.first, cell.second, rivals, territoryDepth);
+
+        if (turn == 0.0f) straightBlocked = score < 0;
+
+        // straight wins ties, so bots don't zigzag across equal regions
+        if (score > bestScore) {
+            bestScore = score;
+            bestTurn = turn;
+        }
+    }
+
+    b.turnInput = bestTurn;
+    b.aiAvoiding = straightBlocked || bestTurn != 0.0f;
+}
+
+// every tick near a wall, another bike (and so its short trail) or while dodging; otherwise
+// proportionally to how far the nearest bike is
+int GameSimulation::thinkInterval(int idx) const {
+    const Bike& b = m_bikes[idx];
+    const float border = m_mapHalfSize - m_cellSize * 2.0f, wallDist = border - std::max(std::fabs(b.pos.x()), std::fabs(b.pos.z()));
+    const float reach = m_maxForwardSpeed * (m_trailTTL + 0.5f);
+    float nearest2 = 1e30f;
+
+    if (b.aiAvoiding || wallDist < m_maxForwardSpeed * 0.5f) return 1;
+
+    for (size_t j = 0; j < m_bikes.size(); ++j) {
+        if (static_cast<int>(j) == idx || !m_bikes[j].alive) continue;
+
+        nearest2 = std::min(nearest2, (m_bikes[j].pos - b.pos).lengthSquared());
+    }
+
+    if (nearest2 <= reach * reach) return 1;
+
+    // walls that stay up can be anywhere, not just behind the other bikes
+    if (m_trailTTL <= 0.0f) {
+        const auto c = cellOf(b.pos);
+
+        if (m_danger.distance(c.first, c.second) < DangerField::maxDistance) return 1;
+    }
+
+    return std::clamp(static_cast<int>(std::sqrt(nearest2) / reach) + 1, 2, maxAiInterval);
+}
+
+void GameSimulation::scheduleBots(float dt) {
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<int>& due = m_due;
+
+    due.clear();
+
+    m_aiStats = AiStats{};
+    m_aiStats.budgetNanoseconds = m_seeded ? 0 : m_aiBudgetNs;
+
+    for (int i = 0; i < static_cast<int>(m_bikes.size()); ++i) {
+        Bike& b = m_bikes[i];
+
+        if (!b.alive || b.human) continue;
+
+        ++m_aiStats.bots;
+        b.aiElapsed += dt;
+
+        if (++b.aiLag >= b.aiInterval) due.push_back(i);
+    }
+
+    // most overdue first, then the tighter interval; index breaks ties so lockstep peers agree
+    std::sort(due.begin(), due.end(), [this](int a, int c) {
+        const Bike& x = m_bikes[a];
+        const Bike& y = m_bikes[c];
+        const int lateX = x.aiLag - x.aiInterval, lateY = y.aiLag - y.aiInterval;
+
+        if (lateX != lateY) return lateX > lateY;
+
+        if (x.aiInterval != y.aiInterval) return x.aiInterval < y.aiInterval;
+
+        return a < c;
+    });
+    m_aiStats.due = static_cast<int>(due.size());
+
+    if (m_botTier == TerritoryBots && !due.empty()) rebuildOccupancy();
+
+    if (m_botTier == ClassicBots) m_planner.update(m_danger, m_tick, planNodeBudget);
+
+    for (int i : due) {
+        Bike& b = m_bikes[i];
+        const int late = b.aiLag - b.aiInterval;
+        bool overBudget = m_seeded ? m_aiStats.thought >= m_aiThinkBudget : std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count() >= m_aiBudgetNs;
+
+        if (overBudget && late < maxAiLag) {
+            ++m_aiStats.deferred;
+
+            continue;
+        }
+
+        m_aiStats.maxLag = std::max(m_aiStats.maxLag, late);
+        if (m_botTier == TerritoryBots) updateBotTerritory(b, i);
+        else updateBot(b, i, b.aiElapsed);
+
+        b.aiElapsed = 0.0f;
+        b.aiLag = 0;
+        b.aiInterval = thinkInterval(i);
+        ++m_aiStats.thought;
+    }
+
+    m_aiStats.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+void GameSimulation::advanceBike(Bike& b, float dt) const {
+    float turnInput = b.turnInput;
+    float currentTurnSpeed = (turnInput > 0) ? m_turnSpeed : (turnInput < 0) ? -m_turnSpeed : 0.0f;
+
+    b.yaw = wrapPi(b.yaw + currentTurnSpeed * dt);
+
+    QVector3D dir = forwardFromYaw(b.yaw);
+    float maxSpeed = m_maxForwardSpeed;
+    float accelFactor = m_acceleration;
+
+    b.speed += (maxSpeed - b.speed) * accelFactor * dt;
+    b.speed = qBound(0.0f, b.speed, maxSpeed);
+
+    QVector3D newPos = b.pos + dir * (b.speed * dt);
+    float border = m_mapHalfSize - m_cellSize * 2.0f;
+
+    newPos.setX(qBound(-border, newPos.x(), border));
+    newPos.setZ(qBound(-border, newPos.z(), border));
+
+    b.pos = b.currPos = newPos;
+}
+
+void GameSimulation::step(float dt) {
+    m_killed.clear();
+
+    if (dt <= 0.0f) return;
+
+    m_time += dt;
+    m_timeMs = static_cast<quint16>(std::lround(m_time * 1000.0f) & 0xFFFF);
+
+    float bikeRadius = 0.8f, trailRadius = 0.3f;
+    int n = static_cast<int>(m_bikes.size());
+    // trail hits are tested on the packed points, in fixed-point steps
+    const float hitRadius = (bikeRadius + trailRadius) * trailStepsPerUnit();
+    const qint64 hitSteps2 = static_cast<qint64>(hitRadius * hitRadius);
+
+    scheduleBots(dt);
+
+    for (int i = 0; i < n; ++i) {
+        Bike& b = m_bikes[i];
+
+        if (!b.alive) continue;
+
+        b.prevPos = b.pos;
+        advanceBike(b, dt);
+
+        auto& trail = m_bikeTrails[i];
+
+        if (trail.empty() || (b.pos - trailPos(trail.back())).lengthSquared() >= m_trailMinDist * m_trailMinDist) addTrailPoint(i);
+    }
+
+    for (int i = 0; i < n; ++i) {
+        if (!m_bikes[i].alive) continue;
+
+        for (int j = i + 1; j < n; ++j) {
+            if (!m_bikes[j].alive) continue;
+
+            if ((m_bikes[i].pos - m_bikes[j].pos).lengthSquared() <= bikeRadius * 2 * bikeRadius * 2) {
+                killBike(i);
+                killBike(j);
+            }
+        }
+    }
+
+    // only the cells the hit circle overlaps, with a step of slack for the rounding of the packed points
+    const float hitReach = bikeRadius + trailRadius + 2.0f / trailStepsPerUnit();
+
+    // with someone listening, the query box also covers the near-miss radius
+    const float queryReach = m_events ? std::max(hitReach, nearMissDist + 2.0f / trailStepsPerUnit()) : hitReach;
+    const float nearSteps = nearMissDist * trailStepsPerUnit();
+
+    for (int i = 0; i < n; ++i) {
+        if (!m_bikes[i].alive) continue;
+
+        const Bike& A = m_bikes[i];
+        const auto lo = cellOf(A.pos - QVector3D(queryReach, 0.0f, queryReach)), hi = cellOf(A.pos + QVector3D(queryReach, 0.0f, queryReach));
+        TrailGrid::Closest closest{static_cast<qint64>(nearSteps * nearSteps)};
+        const Trail& own = m_bikeTrails[i];
+        int grace = 0;
+
+        // the bike's own newest points can't hit it; they are never a minute old, so their wrapping ages are exact
+        while (grace < static_cast<int>(own.size()) && static_cast<quint16>(m_timeMs - own[own.size() - 1 - grace].ms) < ownTrailGraceMs) ++grace;
+
+        // the lowest owner wins, as if the trails were scanned in order
+        const int owner = m_trailGrid.firstHit(lo.first, lo.second, hi.first, hi.second, packTrailPoint(A.pos), hitSteps2, i, own.data() + own.size() - grace, grace, m_events ? &closest : nullptr);
+
+        if (owner >= 0) {
+            killBike(i);
+
+            if (owner != i) m_killedBy[i] = owner;
+        } else if (m_events) {
+            trackNearMiss(i, closest);
+        }
+    }
+
+    m_danger.flush();
+    ++m_tick;
+    foldChecksum();
+
+    if (m_events) publishEvents();
+}
+
+// chained per tick, so two peers' values only match if every earlier tick matched too
+void GameSimulation::foldChecksum() {
+    quint64 h = fnv(m_checksum, &m_tick, sizeof m_tick);
+
+    for (size_t i = 0; i < m_bikes.size(); ++i) {
+        const Bike& b = m_bikes[i];
+        const quint32 trailLen = static_cast<quint32>(m_bikeTrails[i].size());
+        const quint8 alive = b.alive ? 1 : 0;
+
+        h = fnvFloat(h, b.pos.x());
+        h = fnvFloat(h, b.pos.z());
+        h = fnvFloat(h, b.yaw);
+        h = fnvFloat(h, b.speed);
+        h = fnv(h, &alive, sizeof alive);
+        h = fnv(h, &trailLen, sizeof trailLen);
+    }
+
+    m_checksum = fnv(h, &m_rng, sizeof m_rng);
+}
+
+void GameSimulation::expireTrails() {
+    if (m_trailTTL <= 0.0f) return;
+
+    const quint16 ttlMs = static_cast<quint16>(std::min(65535L, std::lround(m_trailTTL * 1000.0f)));
+
+    for (size_t i = 0; i < m_bikeTrails.size(); ++i) {
+        Trail& trail = m_bikeTrails[i];
+        auto firstAlive = std::find_if(trail.begin(), trail.end(), [this, ttlMs](const TrailPoint& tp) { return static_cast<quint16>(m_timeMs - tp.ms) <= ttlMs; });
+
+        for (auto it = trail.begin(); it != firstAlive; ++it) {
+            const auto c = cellOf(trailPos(*it));
+
+            m_danger.removePoint(c.first, c.second);
+            m_trailGrid.remove(c.first, c.second, *it, static_cast<int>(i));
+        }
+
+        m_trailExpired[i] += static_cast<int>(firstAlive - trail.begin());
+        trail.erase(trail.begin(), firstAlive);
+    }
+
+    m_danger.flush();
+}
+
+const std::pmr::vector<GameSimulation::Bike>& GameSimulation::bikes() const { return m_bikes; }
+
+const std::pmr::vector<GameSimulation::Trail>& GameSimulation::trails() const { return m_bikeTrails; }
+
+int GameSimulation::trailExpired(int idx) const { return m_trailExpired[idx]; }
+
+const std::pmr::vector<int>& GameSimulation::killedLastStep() const { return m_killed; }
+
+int GameSimulation::killedBy(int idx) const { return idx >= 0 && idx < static_cast<int>(m_killedBy.size()) ? m_killedBy[idx] : -1; }
+
+int GameSimulation::aliveCount() const { return m_alive; }
+
+int GameSimulation::roundId() const { return m_roundId; }
+
+float GameSimulation::time() const { return m_time; }
+
+int GameSimulation::gridSize() const { return m_gridSize; }
+
+float GameSimulation::cellSize() const { return m_cellSize; }
+
+float GameSimulation::mapHalfSize() const { return m_mapHalfSize; }
+
+float GameSimulation::trailTTL() const { return m_trailTTL; }
+
+float GameSimulation::maxForwardSpeed() const { return m_maxForwardSpeed; }
+
+quint32 GameSimulation::tick() const { return m_tick; }
+
+quint64 GameSimulation::checksum() const { return m_checksum; }
+
+const GameSimulation::AiStats& GameSimulation::aiStats() const { return m_aiStats; }
+
+const DangerField& GameSimulation::dangerField() const { return m_danger; }
+
+const PathPlanner& GameSimulation::pathPlanner() const { return m_planner; }
+
+const RoundArena& GameSimulation::roundArena() const { return *m_arena; }
+
+GameSimulation::BotParams GameSimulation::botParamsFromJson(const QJsonObject& o) {
+    BotParams p;
+    p.lookAheadDist = static_cast<float>(o.value("look_ahead_dist").toDouble(p.lookAheadDist));
+    p.avoidThreshold = static_cast<float>(o.value("avoid_threshold").toDouble(p.avoidThreshold));
+    p.attackDist2 = static_cast<float>(o.value("attack_dist2").toDouble(p.attackDist2));
+    p.minDotAttack = static_cast<float>(o.value("min_dot_attack").toDouble(p.minDotAttack));
+    p.wanderMin = static_cast<float>(o.value("wander_min").toDouble(p.wanderMin));
+    p.wanderRange = static_cast<float>(o.value("wander_range").toDouble(p.wanderRange));
+    p.wanderTurnChance = static_cast<float>(o.value("wander_turn_chance").toDouble(p.wanderTurnChance));
+    p.huntDist = static_cast<float>(o.value("hunt_dist").toDouble(p.huntDist));
+
+    return p;
+}
+
+QJsonObject GameSimulation::botParamsToJson(const BotParams& params) {
+    QJsonObject o;
+    o["look_ahead_dist"] = params.lookAheadDist;
+    o["avoid_threshold"] = params.avoidThreshold;
+    o["attack_dist2"] = params.attackDist2;
+    o["min_dot_attack"] = params.minDotAttack;
+    o["wander_min"] = params.wanderMin;
+    o["wander_range"] = params.wanderRange;
+    o["wander_turn_chance"] = params.wanderTurnChance;
+    o["hunt_dist"] = params.huntDist;
+
+    return o;
+}
+
+QVector3D GameSimulation::forwardFromYaw(float yaw) { return QVector3D(-detSin(yaw), 0.0f, -detCos(yaw)); }
+
+float GameSimulation::wrapPi(float a) {
+    const float twoPi = 2.0f * pi;
+
+    while (a <= -pi) a += twoPi;
+
+    while (a > pi) a -= twoPi;
+
+    return a;
+}
@@ -0,0 +1,240 @@
+#ifndef GAMESIMULATION_H
+#define GAMESIMULATION_H
+
+// Arena simulation shared by the GL game widget and the headless server.
+// Holds the bikes and their light trails, drives the bots and resolves
+// collisions; it has no rendering, audio or window dependencies.
+// Stepping is reproducible bit for bit given the same seed, the same fixed dt
+// and the same inputs (fixed polynomial trigonometry, a private generator, no
+// FMA contraction); checksum() folds the state after every step so peers
+// running in lockstep can compare ticks.
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <QVector3D>
+#include <QJsonObject>
+#include "OccupancyGrid.h"
+#include "DangerField.h"
+#include "PathPlanner.h"
+#include "RoundArena.h"
+#include "TrailGrid.h"
+#include "EventStream.h"
+
+class GameSimulation {
+public:
+    // 6 bytes: X/Z in 16-bit fixed point across the arena (the same grid NetProtocol sends) and the
+    // drop time in milliseconds of round time, wrapping every 65.5 s. Ages are only exact for points
+    // younger than that, which covers every fading trail; persistent walls never look at old ages.
+    // trailPos() and trailAge() unpack them
+    using TrailPoint = TrailGrid::Point;
+
+    using Trail = std::pmr::vector<TrailPoint>;
+
+    struct Bike {
+        QVector3D pos;
+        QVector3D prevPos;
+        QVector3D currPos;
+        float yaw;
+        float speed;
+        float lean;
+        QVector3D color;
+        bool human;
+        bool alive;
+        float aiTurnTimer;
+        float aiTurnDir;
+        float turnInput;
+        // scheduler bookkeeping: time since the last think, ticks since it and the current interval
+        float aiElapsed;
+        int aiLag;
+        int aiInterval;
+        bool aiAvoiding;
+    };
+
+    struct AiStats {
+        int bots = 0;
+        int due = 0;
+        int thought = 0;
+        int deferred = 0;
+        int maxLag = 0;
+        qint64 nanoseconds = 0;
+        qint64 budgetNanoseconds = 0;
+    };
+
+    // steering constants of the classic bots; the defaults are the hand-picked originals
+    struct BotParams {
+        float lookAheadDist = 200.0f;
+        float avoidThreshold = 2.0f;
+        float attackDist2 = 400.0f;
+        float minDotAttack = 0.1f;
+        // seconds a wander turn is held: wanderMin plus up to wanderRange
+        float wanderMin = 0.5f;
+        float wanderRange = 1.5f;
+        // chance of each hard turn when a new wander turn is picked
+        float wanderTurnChance = 0.3f;
+        // the player is hunted along a planned route inside this distance; 0 never plans
+        float huntDist = 60.0f;
+    };
+
+    enum BotTier {
+        ClassicBots,
+        TerritoryBots
+    };
+
+    GameSimulation();
+    void setFieldSize(int n);
+    void setBotCount(int n);
+    void setHumanSlots(int n);
+    void setHumanColor(const QVector3D& color);
+    // seconds a trail point lives, up to 65; 0 keeps walls up until the round ends. Takes effect on the next round
+    void setTrailTTL(float seconds);
+    // where resetRound() and step() write their events, or nullptr; not owned and written from the stepping thread
+    void setEventStream(EventStream* events);
+    // fixed seed for every following round; without one rounds are seeded from the clock
+    void setSeed(quint64 seed);
+    // per-tick AI budget; seeded (deterministic) runs count thinks instead of reading the clock
+    void setAiBudget(int microseconds, int thinks);
+    void setBotTier(BotTier tier);
+    BotTier botTier() const;
+    // parameters for every bot; the per-bike overload lets two parameter sets share a match
+    void setBotParams(const BotParams& params);
+    void setBotParams(int idx, const BotParams& params);
+    const BotParams& botParams(int idx) const;
+    void setHuman(int idx, bool human);
+    void setTurnInput(int idx, float turn);
+    void resetRound();
+    void step(float dt);
+    void expireTrails();
+    void killBike(int idx);
+    // steering and movement of one bike from its turnInput; clients reuse it to predict their own bike
+    void advanceBike(Bike& b, float dt) const;
+
+    const std::pmr::vector<Bike>& bikes() const;
+    const std::pmr::vector<Trail>& trails() const;
+    // number of points dropped from the front of a trail since the round started
+    int trailExpired(int idx) const;
+    const std::pmr::vector<int>& killedLastStep() const;
+    // whose trail killed idx this round; -1 for its own trail, a head-on crash or still alive
+    int killedBy(int idx) const;
+    int aliveCount() const;
+    int roundId() const;
+    float time() const;
+    int gridSize() const;
+    float cellSize() const;
+    float mapHalfSize() const;
+    float trailTTL() const;
+    float maxForwardSpeed() const;
+    // steps since the round started and the rolling state hash after the latest one
+    quint32 tick() const;
+    quint64 checksum() const;
+    const AiStats& aiStats() const;
+    const DangerField& dangerField() const;
+    const PathPlanner& pathPlanner() const;
+    const RoundArena& roundArena() const;
+    static constexpr int maxFanRays = 16;
+    // free distance along `rays` headings spread evenly over yaw +- halfAngle: each ray stops where
+    // the danger field drops to `clearance` cells, or at `range` (world units)
+    void castFan(const QVector3D& origin, float yaw, int rays, float halfAngle, float clearance, float range, float* out) const;
+    QVector3D trailPos(const TrailPoint& tp) const;
+    // seconds since the point was dropped, modulo 65.536
+    float trailAge(const TrailPoint& tp) const;
+    // arena cell of a world position, as used by the danger field and the occupancy grid
+    std::pair<int, int> cellOf(const QVector3D& p) const;
+
+    // "bot_params" object of the environment config section; missing keys keep their defaults
+    static BotParams botParamsFromJson(const QJsonObject& o);
+    static QJsonObject botParamsToJson(const BotParams& params);
+    static float wrapPi(float a);
+    // unit heading for a yaw, identical on every platform
+    static QVector3D forwardFromYaw(float yaw);
+private:
+    void updateBot(Bike& b, int idx, float dt);
+    QVector3D cellCentre(const std::pair<int, int>& c) const;
+    std::pair<int, int> interceptCell(const Bike& target, float dist) const;
+    float steerTowards(const Bike& b, const std::pair<int, int>& cell) const;
+    void updateBotTerritory(Bike& b, int idx);
+    void rebuildOccupancy();
+    // bots think every tick near a wall or another bike and every few ticks when roaming alone, keeping
+    // their steering in between; due bots run most-overdue first within the per-tick budget, and none is
+    // deferred more than maxAiLag ticks past its slot
+    void scheduleBots(float dt);
+    int thinkInterval(int idx) const;
+    float trailStepsPerUnit() const;
+    TrailPoint packTrailPoint(const QVector3D& p) const;
+    // drops a point at the bike's position into its trail, the danger field and the trail grid
+    void addTrailPoint(int idx);
+    float random01();
+    void foldChecksum();
+    GameEvent makeEvent(GameEvent::Type type, int bike, int other, float value) const;
+    void trackNearMiss(int idx, const TrailGrid::Closest& closest);
+    void publishEvents();
+
+    int m_gridSize;
+    float m_cellSize;
+    float m_mapHalfSize;
+    int m_botCount;
+    int m_humanSlots;
+    int m_roundId;
+    QVector3D m_humanColor;
+    // backs bikes, trails and the other per-round containers: resetRound() rewinds it and lays them out
+    // again with a full trail's room per bike (see m_wallCapacity for walls that never expire), so a round
+    // in progress doesn't touch the heap. Declared ahead of the containers it backs, so it is built before
+    // and destroyed after them
+    std::unique_ptr<RoundArena> m_arena;
+    std::pmr::vector<Bike> m_bikes;
+    std::pmr::vector<Trail> m_bikeTrails;
+    std::pmr::vector<int> m_trailExpired;
+    std::pmr::vector<int> m_killed;
+    std::pmr::vector<int> m_killedBy;
+    float m_maxForwardSpeed;
+    float m_acceleration;
+    float m_friction;
+    float m_turnSpeed;
+    float m_trailTTL;
+    float m_trailMinDist;
+    // points reserved per trail when walls don't expire; learnt from earlier rounds
+    size_t m_wallCapacity;
+    float m_time;
+    // m_time in wrapping milliseconds, as trail points carry it
+    quint16 m_timeMs;
+    int m_alive;
+    bool m_roundEnded;
+    // what happened each step (kills, near misses, the end of the round) for the HUD, audio and stats to
+    // drain later; while it is null none of that is tracked
+    EventStream* m_events;
+    // closest rival trail point of each bike while it is within nearMissDist of one
+    std::vector<TrailGrid::Closest> m_nearMiss;
+    quint64 m_seed;
+    bool m_seeded;
+    quint32 m_rng;
+    quint32 m_tick;
+    quint64 m_checksum;
+    qint64 m_aiBudgetNs;
+    int m_aiThinkBudget;
+    AiStats m_aiStats;
+    BotTier m_botTier;
+    BotParams m_botParams;
+    std::vector<BotParams> m_bikeParams;
+    // territory bots: every trail rasterised once per tick, each bot picks the turn whose short look-ahead
+    // leaves it the largest Voronoi region
+    OccupancyGrid m_occupancy;
+    // classic bots: follows trail growth and expiry incrementally; they cast a fan of rays over it and turn
+    // towards the roomiest ray when the way ahead is blocked within their look-ahead
+    DangerField m_danger;
+    // trail points bucketed per cell, so a bike is only tested against the points around it and nothing per
+    // tick walks whole trails; that is what makes walls that never expire (TTL 0) cost the same
+    TrailGrid m_trailGrid;
+    // shared by classic bots out of danger: routes to where the player is heading within huntDist, or out
+    // to the nearest open region when every ray is short
+    PathPlanner m_planner;
+    std::vector<std::pair<int, int>> m_bikeCells;
+    // per-tick scratch kept as members so stepping doesn't allocate
+    std::vector<int> m_due;
+    std::vector<std::pair<int, int>> m_rivals;
+};
+
+#endif // GAMESIMULATION_H
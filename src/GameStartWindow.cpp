@@ -53,6 +53,8 @@ GameDefaults& defaults() {
 int g_current_field_size = -1;
 int g_current_bots_count = -1;
 int g_current_rounds_count = 3;
+// 0 = classic bots, 1 = territory bots; HARDER past the bot cap switches to the smarter tier
+int g_current_bot_tier = 0;
 const int g_rounds_min = 1;
 const int g_rounds_max = 50;
 
@@ -113,7 +115,7 @@ GameStartWindow::GameStartWindow(QWidget* parent) : QDialog(parent) {
     auto* rounds_count = new QLineEdit(this);
     auto* less_rounds_button = new QPushButton("-");
     auto* set_bots_layout = new QVBoxLayout(this);
-    auto* bots_hint = new QLabel("BOTS:");
+    auto* bots_hint = new QLabel(g_current_bot_tier ? "SMART BOTS:" : "BOTS:");
     auto* bots_change_layout = new QHBoxLayout(this);
     auto* more_bots_button = new QPushButton("HARDER");
     auto* bots_count = new QLineEdit(this);
@@ -345,7 +347,7 @@ GameStartWindow::GameStartWindow(QWidget* parent) : QDialog(parent) {
 
             while (w && qobject_cast<mainwindow*>(w) == nullptr) w = w->parentWidget();
 
-            if (auto* mw = qobject_cast<mainwindow*>(w)) mw->startGame(g_current_field_size, g_current_bots_count, g_current_rounds_count);
+            if (auto* mw = qobject_cast<mainwindow*>(w)) mw->startGame(g_current_field_size, g_current_bots_count, g_current_rounds_count, g_current_bot_tier);
 
             if (!closing) {
                 closing = true;
@@ -395,7 +397,7 @@ GameStartWindow::GameStartWindow(QWidget* parent) : QDialog(parent) {
     );
     // HARDER
     connect(more_bots_button, &QPushButton::clicked, this,
-        [bots_count, bots_min, bots_max]() {
+        [bots_count, bots_hint, bots_min, bots_max]() {
             bool ok = false;
             int bots = bots_count->text().toInt(&ok);
 
@@ -405,18 +407,24 @@ GameStartWindow::GameStartWindow(QWidget* parent) : QDialog(parent) {
                 ++bots;
                 g_current_bots_count = bots;
                 bots_count->setText(QString::number(bots));
+            } else if (g_current_bot_tier == 0) {
+                g_current_bot_tier = 1;
+                bots_hint->setText("SMART BOTS:");
             }
         }
     );
     // SIMPLER
     connect(less_bots_button, &QPushButton::clicked, this,
-        [bots_count, bots_min, bots_max]() {
+        [bots_count, bots_hint, bots_min, bots_max]() {
             bool ok = false;
             int bots = bots_count->text().toInt(&ok);
 
             if (!ok) bots = bots_min;
             
-            if (bots > bots_min) {
+            if (g_current_bot_tier != 0) {
+                g_current_bot_tier = 0;
+                bots_hint->setText("BOTS:");
+            } else if (bots > bots_min) {
                 --bots;
                 g_current_bots_count = bots;
                 bots_count->setText(QString::number(bots));
@@ -0,0 +1,340 @@
+#include "GridBot.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// headings are indexed Up, Down, Left, Right so that a ^ 1 is the reverse
+const int headingDx[4] = {0, 0, -1, 1};
+const int headingDy[4] = {-1, 1, 0, 0};
+const float exploration = 0.7f;
+
+bool sameState(const GridState& a, const GridState& b) {
+    if (a.active != b.active) return false;
+
+    for (int p = 0; p < 2; ++p) {
+        if (a.x[p] != b.x[p] || a.y[p] != b.y[p] || a.dx[p] != b.dx[p] || a.dy[p] != b.dy[p] || a.alive[p] != b.alive[p]) return false;
+
+        if (a.trail[p] != b.trail[p]) return false;
+    }
+
+    return true;
+}
+
+}
+
+GridBot::GridBot(int player, int threads) : m_player(std::clamp(player, 0, 1)) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    m_trees.resize(std::clamp(threads, 1, 16));
+
+    for (size_t i = 0; i < m_trees.size(); ++i) {
+        Tree& t = m_trees[i];
+
+        t.rng = 0x9E3779B9u * static_cast<quint32>(i + 1);
+        t.capacity = maxNodes / static_cast<int>(m_trees.size());
+        t.nodes.reserve(t.capacity);
+        t.spare.reserve(t.capacity);
+    }
+
+    for (size_t i = 0; i < m_trees.size(); ++i) m_workers.emplace_back([this, i]() { workerLoop(static_cast<int>(i)); });
+}
+
+GridBot::~GridBot() {
+    finish();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_wake.notify_all();
+
+    for (std::thread& w : m_workers) w.join();
+}
+
+int GridBot::player() const { return m_player; }
+
+int GridBot::lastPlayouts() const { return m_lastPlayouts; }
+
+int GridBot::lastReused() const { return m_lastReused; }
+
+void GridBot::start(const GridState& state, int budgetMs) {
+    finish();
+
+    if (!state.active) return;
+
+    m_stop = false;
+    m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(1, budgetMs));
+    m_lastReused = 0;
+
+    for (Tree& t : m_trees) {
+        reroot(t, state);
+        m_lastReused += static_cast<int>(t.nodes[0].total);
+        t.playouts = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+        m_pending = static_cast<int>(m_trees.size());
+        m_searching = true;
+    }
+
+    m_wake.notify_all();
+}
+
+quint8 GridBot::finish() {
+    if (!m_searching) return GridState::None;
+
+    m_stop = true;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this]() { return m_pending == 0; });
+        m_searching = false;
+    }
+
+    std::array<quint64, 4> visits{};
+
+    m_lastPlayouts = 0;
+
+    for (const Tree& t : m_trees) {
+        m_lastPlayouts += t.playouts;
+
+        for (int a = 0; a < 4; ++a) visits[a] += t.nodes[0].visits[m_player * 4 + a];
+    }
+
+    const GridState& root = m_trees[0].root;
+    const int reverse = heading(root, m_player) ^ 1;
+    int best = heading(root, m_player);
+
+    for (int a = 0; a < 4; ++a) {
+        if (a != reverse && visits[a] > visits[best]) best = a;
+    }
+
+    return static_cast<quint8>(GridState::Up + best);
+}
+
+void GridBot::workerLoop(int worker) {
+    quint64 seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+
+            if (m_quit) return;
+
+            seen = m_generation;
+        }
+
+        search(m_trees[worker]);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (--m_pending == 0) m_finished.notify_one();
+    }
+}
+
+int GridBot::heading(const GridState& s, int player) {
+    if (s.dy[player] < 0) return 0;
+
+    if (s.dy[player] > 0) return 1;
+
+    return s.dx[player] < 0 ? 2 : 3;
+}
+
+quint32 GridBot::nextRandom(quint32& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+
+    return rng;
+}
+
+float GridBot::reward(const GridState& s) {
+    if (s.active || s.alive[0] == s.alive[1]) return 0.5f;
+
+    return s.alive[0] ? 1.0f : 0.0f;
+}
+
+int GridBot::newNode(Tree& t) const {
+    // the reserve is never outgrown, so the tree doesn't reallocate mid-search
+    if (static_cast<int>(t.nodes.size()) >= t.capacity) return -1;
+
+    Node n;
+    n.child.fill(-1);
+    n.visits.fill(0);
+    n.wins.fill(0.0f);
+    t.nodes.push_back(n);
+
+    return static_cast<int>(t.nodes.size()) - 1;
+}
+
+// keeps the subtree of the joint move that led from the old root to `state`, or starts over
+void GridBot::reroot(Tree& t, const GridState& state) {
+    int keep = -1;
+
+    if (t.valid && !t.nodes.empty()) {
+        if (sameState(t.root, state)) {
+            keep = 0;
+        } else if (t.root.active) {
+            const int a0 = heading(state, 0), a1 = heading(state, 1);
+            const quint8 input[2] = {static_cast<quint8>(GridState::Up + a0), static_cast<quint8>(GridState::Up + a1)};
+            GridState next = t.root;
+
+            next.step(input);
+
+            if (sameState(next, state)) keep = t.nodes[0].child[a0 * 4 + a1];
+        }
+    }
+
+    if (keep > 0) {
+        // breadth-first copy so the kept subtree is compact again and the rest is dropped
+        t.spare.clear();
+        t.spare.push_back(t.nodes[keep]);
+
+        for (size_t i = 0; i < t.spare.size(); ++i) {
+            for (int k = 0; k < 16; ++k) {
+                const qint32 c = t.spare[i].child[k];
+
+                if (c < 0) continue;
+
+                t.spare.push_back(t.nodes[c]);
+                t.spare[i].child[k] = static_cast<qint32>(t.spare.size()) - 1;
+            }
+        }
+
+        std::swap(t.nodes, t.spare);
+    } else if (keep < 0) {
+        t.nodes.clear();
+        newNode(t);
+    }
+
+    t.root = state;
+    t.valid = true;
+}
+
+void GridBot::search(Tree& t) {
+    GridState s;
+
+    while (!m_stop) {
+        for (int i = 0; i < 32; ++i) {
+            s = t.root;
+            descend(t, s);
+            ++t.playouts;
+        }
+
+        if (std::chrono::steady_clock::now() >= m_deadline) break;
+    }
+}
+
+// one iteration: select down the tree, expand one node, play out, back the result up
+float GridBot::descend(Tree& t, GridState& s) {
+    struct Step {
+        int node;
+        int a[2];
+    };
+
+    Step path[maxPlayoutSteps * 2];
+    int depth = 0;
+    int idx = 0;
+    float r = 0.5f;
+
+    while (true) {
+        if (!s.active) {
+            r = reward(s);
+            break;
+        }
+
+        Step& st = path[depth];
+        const Node& n = t.nodes[idx];
+        const float logTotal = std::log(static_cast<float>(n.total) + 1.0f);
+
+        st.node = idx;
+
+        for (int p = 0; p < 2; ++p) {
+            const int reverse = heading(s, p) ^ 1;
+            float bestScore = -1.0f;
+
+            st.a[p] = reverse ^ 1;
+
+            for (int a = 0; a < 4; ++a) {
+                if (a == reverse) continue;
+
+                const quint32 v = n.visits[p * 4 + a];
+                const float score = v == 0 ? 1e9f + (nextRandom(t.rng) & 0xFF) : n.wins[p * 4 + a] / v + exploration * std::sqrt(logTotal / v);
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    st.a[p] = a;
+                }
+            }
+        }
+
+        const quint8 input[2] = {static_cast<quint8>(GridState::Up + st.a[0]), static_cast<quint8>(GridState::Up + st.a[1])};
+
+        s.step(input);
+        ++depth;
+
+        const int slot = st.a[0] * 4 + st.a[1];
+        int c = t.nodes[idx].child[slot];
+
+        if (c < 0 || depth >= maxPlayoutSteps * 2) {
+            if (c < 0 && s.active) {
+                c = newNode(t);
+
+                if (c >= 0) t.nodes[idx].child[slot] = c;
+            }
+
+            r = playout(t, s);
+            break;
+        }
+
+        idx = c;
+    }
+
+    for (int i = 0; i < depth; ++i) {
+        Node& n = t.nodes[path[i].node];
+
+        n.visits[path[i].a[0]] += 1;
+        n.wins[path[i].a[0]] += r;
+        n.visits[4 + path[i].a[1]] += 1;
+        n.wins[4 + path[i].a[1]] += 1.0f - r;
+        ++n.total;
+    }
+
+    return r;
+}
+
+// random steering that avoids walls and trails one cell ahead when it can
+float GridBot::playout(Tree& t, GridState& s) const {
+    for (int step = 0; step < maxPlayoutSteps && s.active; ++step) {
+        quint8 input[2];
+
+        for (int p = 0; p < 2; ++p) {
+            const int reverse = heading(s, p) ^ 1;
+            int safe[3];
+            int count = 0;
+
+            for (int a = 0; a < 4; ++a) {
+                if (a == reverse) continue;
+
+                const int nx = s.x[p] + headingDx[a], ny = s.y[p] + headingDy[a];
+
+                if (nx < 0 || ny < 0 || nx >= GridState::width || ny >= GridState::height) continue;
+
+                if (s.occupied(0, nx, ny) || s.occupied(1, nx, ny)) continue;
+
+                safe[count++] = a;
+            }
+
+            input[p] = count ? static_cast<quint8>(GridState::Up + safe[nextRandom(t.rng) % count]) : GridState::None;
+        }
+
+        s.step(input);
+    }
+
+    return reward(s);
+}
@@ -0,0 +1,93 @@
+#ifndef GRIDBOT_H
+#define GRIDBOT_H
+
+// Computer opponent for the 2-player grid mode.
+// Monte-Carlo tree search over GridState with decoupled UCT: both bikes move at
+// once, so every node keeps separate move statistics per player and children are
+// indexed by the joint move. Moves are absolute headings (reversing is suicide
+// and never tried); playouts steer randomly around immediate walls.
+// Search is root-parallel: each thread of a fixed pool grows its own tree from
+// the same position and the root visit counts are summed when the move is taken.
+// The trees split one node budget between them and reserve their share up front,
+// so memory doesn't grow with the core count and searching doesn't allocate. It
+// runs in the background between two game ticks (start() wakes the pool right
+// after a step, finish() stops it just before the next one), and each tree keeps
+// the subtree of the move that was actually played for the next search.
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "RollbackSession.h"
+
+class GridBot {
+public:
+    // the bot steers `player`; threads <= 0 uses every core
+    explicit GridBot(int player, int threads = 0);
+    ~GridBot();
+    GridBot(const GridBot&) = delete;
+    GridBot& operator=(const GridBot&) = delete;
+
+    // searches `state` on the worker threads until finish() or the budget runs out
+    void start(const GridState& state, int budgetMs);
+    // stops the search and returns the turn to feed into GridState::step
+    quint8 finish();
+    int player() const;
+    // playouts and reused root visits of the last finished search, over all trees
+    int lastPlayouts() const;
+    int lastReused() const;
+private:
+    // nodes over all trees; each also keeps a same-sized buffer for re-rooting
+    static constexpr int maxNodes = 1 << 16;
+    static constexpr int maxPlayoutSteps = 80;
+
+    struct Node {
+        std::array<qint32, 16> child;
+        std::array<quint32, 8> visits;
+        std::array<float, 8> wins;
+        quint32 total = 0;
+    };
+
+    struct Tree {
+        std::vector<Node> nodes;
+        std::vector<Node> spare;
+        GridState root;
+        // this tree's share of maxNodes
+        int capacity = 0;
+        bool valid = false;
+        quint32 rng = 1;
+        int playouts = 0;
+    };
+
+    void workerLoop(int worker);
+    void reroot(Tree& t, const GridState& state);
+    void search(Tree& t);
+    float descend(Tree& t, GridState& s);
+    float playout(Tree& t, GridState& s) const;
+    int newNode(Tree& t) const;
+    static float reward(const GridState& s);
+    static int heading(const GridState& s, int player);
+    static quint32 nextRandom(quint32& rng);
+
+    int m_player;
+    std::vector<Tree> m_trees;
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_stop{false};
+    std::chrono::steady_clock::time_point m_deadline;
+    // pool handshake: start() bumps the generation, every worker searches its tree once per bump
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    quint64 m_generation = 0;
+    int m_pending = 0;
+    bool m_searching = false;
+    bool m_quit = false;
+    int m_lastPlayouts = 0;
+    int m_lastReused = 0;
+};
+
+#endif // GRIDBOT_H
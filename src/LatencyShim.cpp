@@ -0,0 +1,76 @@
+#include "LatencyShim.h"
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+
+LatencyShim::LatencyShim(const QHostAddress& target, quint16 targetPort, int rttMs, int jitterMs, double lossPercent, QObject* parent)
+    : QObject(parent), m_target(target), m_targetPort(targetPort), m_oneWayMs(std::max(0, rttMs) / 2), m_jitterMs(std::max(0, jitterMs)), m_loss(lossPercent / 100.0) {
+    m_front = new QUdpSocket(this);
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_front, &QUdpSocket::readyRead, this, &LatencyShim::onClientDatagrams);
+    connect(m_flushTimer, &QTimer::timeout, this, &LatencyShim::onFlush);
+}
+
+bool LatencyShim::start(quint16 listenPort) {
+    if (!m_front->bind(QHostAddress::LocalHost, listenPort)) {
+        qWarning() << "LatencyShim: cannot bind UDP port" << listenPort << m_front->errorString();
+
+        return false;
+    }
+
+    m_clock.start();
+    m_flushTimer->start(1);
+    qInfo() << "LatencyShim: relaying" << port() << "->" << m_targetPort << "rtt" << m_oneWayMs * 2 << "ms, jitter" << m_jitterMs << "ms, loss" << m_loss * 100.0 << "%";
+
+    return true;
+}
+
+quint16 LatencyShim::port() const { return m_front->localPort(); }
+
+LatencyShim::Route& LatencyShim::routeFor(const QHostAddress& address, quint16 port) {
+    for (Route& r : m_routes) {
+        if (r.port == port && r.address.isEqual(address)) return r;
+    }
+
+    auto* upstream = new QUdpSocket(this);
+    upstream->bind(QHostAddress::AnyIPv4, 0);
+    connect(upstream, &QUdpSocket::readyRead, this, [this, upstream, address, port]() { onServerDatagrams(upstream, address, port); });
+    m_routes.push_back({address, port, upstream});
+
+    return m_routes.back();
+}
+
+void LatencyShim::onClientDatagrams() {
+    while (m_front->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_front->receiveDatagram();
+        Route& route = routeFor(datagram.senderAddress(), static_cast<quint16>(datagram.senderPort()));
+
+        schedule(route.upstream, datagram.data(), m_target, m_targetPort);
+    }
+}
+
+void LatencyShim::onServerDatagrams(QUdpSocket* upstream, const QHostAddress& address, quint16 port) {
+    while (upstream->hasPendingDatagrams()) schedule(m_front, upstream->receiveDatagram().data(), address, port);
+}
+
+void LatencyShim::schedule(QUdpSocket* socket, const QByteArray& data, const QHostAddress& to, quint16 port) {
+    QRandomGenerator* rng = QRandomGenerator::global();
+
+    if (m_loss > 0.0 && rng->generateDouble() < m_loss) return;
+
+    // independent jitter per datagram, so reordering happens just like on a real link
+    qint64 due = m_clock.elapsed() + m_oneWayMs + (m_jitterMs > 0 ? rng->bounded(m_jitterMs + 1) : 0);
+
+    m_pending.push_back({due, socket, data, to, port});
+}
+
+void LatencyShim::onFlush() {
+    const qint64 now = m_clock.elapsed();
+    auto ready = std::stable_partition(m_pending.begin(), m_pending.end(), [now](const Pending& p) { return p.dueMs <= now; });
+
+    for (auto it = m_pending.begin(); it != ready; ++it) it->socket->writeDatagram(it->data, it->to, it->port);
+
+    m_pending.erase(m_pending.begin(), ready);
+}
@@ -0,0 +1,56 @@
+#ifndef LATENCYSHIM_H
+#define LATENCYSHIM_H
+
+// Loopback UDP relay that delays, jitters and drops datagrams in both directions.
+// Clients talk to the shim's port instead of the server's; each client gets its own
+// upstream socket so the server still sees distinct endpoints.
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <vector>
+
+class LatencyShim : public QObject {
+    Q_OBJECT
+public:
+    // rttMs is split evenly between the two directions; jitterMs is added per datagram
+    LatencyShim(const QHostAddress& target, quint16 targetPort, int rttMs, int jitterMs, double lossPercent, QObject* parent = nullptr);
+    bool start(quint16 listenPort = 0);
+    quint16 port() const;
+private slots:
+    void onClientDatagrams();
+    void onFlush();
+private:
+    struct Route {
+        QHostAddress address;
+        quint16 port;
+        QUdpSocket* upstream;
+    };
+
+    struct Pending {
+        qint64 dueMs;
+        QUdpSocket* socket;
+        QByteArray data;
+        QHostAddress to;
+        quint16 port;
+    };
+
+    Route& routeFor(const QHostAddress& address, quint16 port);
+    void onServerDatagrams(QUdpSocket* upstream, const QHostAddress& address, quint16 port);
+    void schedule(QUdpSocket* socket, const QByteArray& data, const QHostAddress& to, quint16 port);
+
+    QHostAddress m_target;
+    quint16 m_targetPort;
+    int m_oneWayMs;
+    int m_jitterMs;
+    double m_loss;
+    QUdpSocket* m_front;
+    QTimer* m_flushTimer;
+    QElapsedTimer m_clock;
+    std::vector<Route> m_routes;
+    std::vector<Pending> m_pending;
+};
+
+#endif // LATENCYSHIM_H
@@ -0,0 +1,215 @@
+#include "LockstepPeer.h"
+#include "NetProtocol.h"
+#include <QNetworkDatagram>
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const quint16 lockstepMagic = 0x4C4B; // "LK"
+const quint8 lockstepVersion = 2;
+
+}
+
+LockstepPeer::LockstepPeer(const Config& config, QObject* parent) : QObject(parent), m_config(config) {
+    m_config.players = std::max(1, m_config.players);
+    m_config.tickRate = std::max(1, m_config.tickRate);
+    m_config.inputDelay = std::clamp(m_config.inputDelay, 0, ring / 4);
+    m_socket = new QUdpSocket(this);
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_socket, &QUdpSocket::readyRead, this, &LockstepPeer::onReadyRead);
+    connect(m_timer, &QTimer::timeout, this, &LockstepPeer::onTimer);
+
+    m_inputs.resize(m_config.players);
+    m_inputTicks.resize(m_config.players);
+    m_remoteChecksums.resize(m_config.players);
+    m_remoteChecksumTicks.resize(m_config.players);
+
+    for (int s = 0; s < m_config.players; ++s) {
+        m_inputTicks[s].fill(none);
+        m_remoteChecksumTicks[s].fill(none);
+    }
+
+    m_checksumTicks.fill(none);
+    m_sim.setSeed(m_config.seed);
+    m_sim.setFieldSize(m_config.fieldSize);
+    m_sim.setBotCount(m_config.bots);
+    m_sim.setHumanSlots(m_config.players);
+    m_sim.resetRound();
+    m_localTick = static_cast<quint32>(m_config.inputDelay);
+}
+
+bool LockstepPeer::bind(quint16 port) {
+    if (m_socket->bind(QHostAddress::AnyIPv4, port)) return true;
+
+    qWarning() << "LockstepPeer: cannot bind UDP port" << port << m_socket->errorString();
+
+    return false;
+}
+
+quint16 LockstepPeer::port() const { return m_socket->localPort(); }
+
+void LockstepPeer::addPeer(const QHostAddress& address, quint16 port) { m_peers.push_back({address, port, 0}); }
+
+void LockstepPeer::start() { m_timer->start(std::max(1, 1000 / m_config.tickRate)); }
+
+void LockstepPeer::setTurnInput(float turn) { m_turn = turn; }
+
+void LockstepPeer::injectFault(quint32 tick) { m_faultTick = tick; }
+
+const GameSimulation& LockstepPeer::simulation() const { return m_sim; }
+
+quint32 LockstepPeer::tick() const { return m_nextTick; }
+
+bool LockstepPeer::isDesynced() const { return m_desynced; }
+
+qint64 LockstepPeer::bytesSent() const { return m_bytesSent; }
+
+// the first inputDelay ticks have no inputs from anyone and run straight ahead
+bool LockstepPeer::inputsReady(quint32 tick) const {
+    if (tick < static_cast<quint32>(m_config.inputDelay)) return true;
+
+    for (int s = 0; s < m_config.players; ++s) {
+        if (m_inputTicks[s][tick % ring] != tick) return false;
+    }
+
+    return true;
+}
+
+void LockstepPeer::onTimer() {
+    if (m_desynced) return;
+
+    // don't schedule inputs further ahead than the rings can hold
+    if (m_localTick < m_nextTick + ring / 2) {
+        const int i = static_cast<int>(m_localTick % ring);
+
+        m_inputs[m_config.slot][i] = NetProtocol::quantizeTurn(m_turn);
+        m_inputTicks[m_config.slot][i] = m_localTick;
+        ++m_localTick;
+    }
+
+    for (int steps = 0; steps < maxCatchUp && !m_desynced && inputsReady(m_nextTick); ++steps) stepOnce();
+
+    send();
+}
+
+void LockstepPeer::stepOnce() {
+    const quint32 t = m_nextTick;
+
+    if (m_roundOverTicks >= 0) {
+        if (--m_roundOverTicks < 0) m_sim.resetRound();
+    } else {
+        for (int s = 0; s < m_config.players; ++s) {
+            const bool known = m_inputTicks[s][t % ring] == t;
+
+            m_sim.setTurnInput(s, known ? NetProtocol::dequantizeTurn(m_inputs[s][t % ring]) : 0.0f);
+        }
+
+        if (t == m_faultTick) m_sim.setTurnInput(m_config.slot, m_sim.bikes()[m_config.slot].turnInput > 0.0f ? -1.0f : 1.0f);
+
+        m_sim.step(1.0f / static_cast<float>(m_config.tickRate));
+        m_sim.expireTrails();
+
+        if (m_sim.aliveCount() <= 1) m_roundOverTicks = 2 * m_config.tickRate;
+    }
+
+    m_checksums[t % ring] = m_sim.checksum();
+    m_checksumTicks[t % ring] = t;
+    ++m_nextTick;
+
+    for (int s = 0; s < m_config.players; ++s) {
+        if (s != m_config.slot && m_remoteChecksumTicks[s][t % ring] == t) compare(t, s, m_remoteChecksums[s][t % ring]);
+    }
+}
+
+void LockstepPeer::compare(quint32 tick, int slot, quint64 remote) {
+    const quint64 local = m_checksums[tick % ring];
+
+    if (local == remote || m_desynced) return;
+
+    m_desynced = true;
+    m_timer->stop();
+    qWarning().nospace() << "LockstepPeer: desync at tick " << tick << " (round " << m_sim.roundId() << "), slot " << m_config.slot
+        << " has " << Qt::hex << local << ", slot " << Qt::dec << slot << " has " << Qt::hex << remote;
+    emit desyncDetected(tick, slot, local, remote);
+}
+
+// every packet repeats all our inputs from the tick the peer has reached, so no run of losses can
+// stall the match for good; checksums only cover the last few ticks, a lost one just skips a comparison
+void LockstepPeer::send() {
+    const quint32 inputEnd = m_localTick, sumEnd = m_nextTick, sumFrom = sumEnd > redundancy ? sumEnd - redundancy : 0;
+
+    for (const Peer& p : m_peers) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        // older inputs are gone from the ring, and the peer can't be waiting on them
+        const quint32 inputFrom = std::max({static_cast<quint32>(m_config.inputDelay), p.ack, inputEnd > ring ? inputEnd - ring : 0u});
+
+        out << lockstepMagic << lockstepVersion << quint8(m_config.slot) << m_nextTick;
+        out << inputFrom << quint16(inputEnd > inputFrom ? inputEnd - inputFrom : 0);
+
+        for (quint32 t = inputFrom; t < inputEnd; ++t) out << m_inputs[m_config.slot][t % ring];
+
+        out << sumFrom << quint8(sumEnd - sumFrom);
+
+        for (quint32 t = sumFrom; t < sumEnd; ++t) out << m_checksums[t % ring];
+
+        const qint64 sent = m_socket->writeDatagram(data, p.address, p.port);
+
+        if (sent > 0) m_bytesSent += sent;
+    }
+}
+
+void LockstepPeer::onReadyRead() {
+    while (m_socket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket->receiveDatagram();
+        QByteArray data = datagram.data();
+        QDataStream in(data);
+        quint16 magic, inputs;
+        quint8 version, slot, count;
+        quint32 ack, from;
+
+        in >> magic >> version >> slot >> ack;
+
+        if (in.status() != QDataStream::Ok || magic != lockstepMagic || version != lockstepVersion) continue;
+
+        if (slot >= m_config.players || slot == m_config.slot) continue;
+
+        for (Peer& p : m_peers) {
+            if (p.address.isEqual(datagram.senderAddress()) && p.port == datagram.senderPort()) p.ack = std::max(p.ack, ack);
+        }
+
+        in >> from >> inputs;
+
+        for (quint32 t = from; t < from + inputs && in.status() == QDataStream::Ok; ++t) {
+            qint8 turn;
+            in >> turn;
+
+            // a truncated datagram must not plant a made-up input
+            if (in.status() != QDataStream::Ok) break;
+
+            if (t >= m_nextTick && t < m_nextTick + ring) {
+                m_inputs[slot][t % ring] = turn;
+                m_inputTicks[slot][t % ring] = t;
+            }
+        }
+
+        in >> from >> count;
+
+        for (quint32 t = from; t < from + count && in.status() == QDataStream::Ok; ++t) {
+            quint64 sum;
+            in >> sum;
+
+            if (in.status() != QDataStream::Ok) break;
+
+            if (t < m_nextTick) {
+                if (m_checksumTicks[t % ring] == t) compare(t, slot, sum);
+            } else if (t < m_nextTick + ring) {
+                m_remoteChecksums[slot][t % ring] = sum;
+                m_remoteChecksumTicks[slot][t % ring] = t;
+            }
+        }
+    }
+}
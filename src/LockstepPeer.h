@@ -0,0 +1,87 @@
+#ifndef LOCKSTEPPEER_H
+#define LOCKSTEPPEER_H
+
+// Deterministic lockstep over UDP: every peer runs the full GameSimulation and
+// only turn inputs cross the network. A tick is simulated once every player's
+// input for it has arrived (local inputs are scheduled a few ticks ahead to hide
+// latency). Peers also exchange the GameSimulation checksum of each tick, so the
+// first tick at which two machines disagree is reported the moment both have run it.
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <array>
+#include <vector>
+#include "GameSimulation.h"
+
+class LockstepPeer : public QObject {
+    Q_OBJECT
+public:
+    struct Config {
+        int slot = 0;
+        int players = 2;
+        int bots = 8;
+        int fieldSize = 150;
+        int tickRate = 60;
+        int inputDelay = 3;
+        quint64 seed = 1;
+    };
+
+    explicit LockstepPeer(const Config& config, QObject* parent = nullptr);
+    bool bind(quint16 port = 0);
+    quint16 port() const;
+    void addPeer(const QHostAddress& address, quint16 port);
+    void start();
+    void setTurnInput(float turn);
+    // testing aid: steer our own bike differently at this tick without telling anyone
+    void injectFault(quint32 tick);
+    const GameSimulation& simulation() const;
+    quint32 tick() const;
+    bool isDesynced() const;
+    qint64 bytesSent() const;
+signals:
+    void desyncDetected(quint32 tick, int remoteSlot, quint64 localChecksum, quint64 remoteChecksum);
+private slots:
+    void onReadyRead();
+    void onTimer();
+private:
+    static constexpr int ring = 256;
+    static constexpr int redundancy = 8;
+    static constexpr int maxCatchUp = 5;
+    static constexpr quint32 none = 0xFFFFFFFFu;
+
+    struct Peer {
+        QHostAddress address;
+        quint16 port;
+        // the peer's next tick to simulate: it holds all our inputs before it
+        quint32 ack;
+    };
+
+    bool inputsReady(quint32 tick) const;
+    void stepOnce();
+    void send();
+    void compare(quint32 tick, int slot, quint64 remote);
+
+    Config m_config;
+    QUdpSocket* m_socket;
+    QTimer* m_timer;
+    GameSimulation m_sim;
+    std::vector<Peer> m_peers;
+    // per player slot: input and the tick it belongs to
+    std::vector<std::array<qint8, ring>> m_inputs;
+    std::vector<std::array<quint32, ring>> m_inputTicks;
+    std::array<quint64, ring> m_checksums;
+    std::array<quint32, ring> m_checksumTicks;
+    std::vector<std::array<quint64, ring>> m_remoteChecksums;
+    std::vector<std::array<quint32, ring>> m_remoteChecksumTicks;
+    quint32 m_nextTick = 0;
+    quint32 m_localTick = 0;
+    quint32 m_faultTick = none;
+    int m_roundOverTicks = -1;
+    float m_turn = 0.0f;
+    bool m_desynced = false;
+    qint64 m_bytesSent = 0;
+};
+
+#endif // LOCKSTEPPEER_H
@@ -0,0 +1,90 @@
+#include "MatchHost.h"
+#include <QDebug>
+
+MatchHost::MatchHost(const GameServer::Config& config, int instances, int threads, QObject* parent) : QObject(parent), m_config(config) {
+    const int pool = std::clamp(threads, 1, std::max(1, instances));
+
+    m_config.logStats = false;
+
+    for (int t = 0; t < pool; ++t) {
+        QThread* thread = new QThread(this);
+        thread->setObjectName(QString("match-worker-%1").arg(t));
+        m_threads.push_back(thread);
+    }
+
+    // servers are built here and handed to their worker before anything touches their sockets
+    for (int i = 0; i < std::max(1, instances); ++i) {
+        GameServer::Config c = m_config;
+        c.port = static_cast<quint16>(m_config.port + i);
+
+        Instance instance;
+        instance.server = new GameServer(c);
+        instance.thread = i % pool;
+        instance.server->moveToThread(m_threads[instance.thread]);
+        m_instances.push_back(instance);
+    }
+
+    m_reportTimer = new QTimer(this);
+    connect(m_reportTimer, &QTimer::timeout, this, &MatchHost::report);
+}
+
+MatchHost::~MatchHost() {
+    for (Instance& instance : m_instances) {
+        GameServer* server = instance.server;
+
+        if (m_threads[instance.thread]->isRunning()) QMetaObject::invokeMethod(server, [server]() { delete server; }, Qt::BlockingQueuedConnection);
+        else delete server;
+    }
+
+    for (QThread* thread : m_threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+bool MatchHost::start() {
+    for (QThread* thread : m_threads) thread->start();
+
+    for (Instance& instance : m_instances) {
+        bool ok = false;
+
+        QMetaObject::invokeMethod(instance.server, &GameServer::start, Qt::BlockingQueuedConnection, &ok);
+
+        if (!ok) return false;
+
+        instance.port = instance.server->port();
+    }
+
+    m_clock.start();
+    m_reportTimer->start(5000);
+    qInfo() << "MatchHost:" << m_instances.size() << "matches on" << m_threads.size() << "worker threads, ports" << m_instances.front().port << "-" << m_instances.back().port;
+
+    return true;
+}
+
+int MatchHost::instanceCount() const { return static_cast<int>(m_instances.size()); }
+
+quint16 MatchHost::instancePort(int idx) const { return m_instances[idx].port; }
+
+// cpu% is busy time inside the instance's handlers relative to one core over the interval
+void MatchHost::report() {
+    const qint64 nowMs = m_clock.elapsed(), intervalNs = std::max<qint64>(1, nowMs - m_lastReportMs) * 1000000;
+    std::vector<qint64> threadBusy(m_threads.size(), 0);
+
+    m_lastReportMs = nowMs;
+
+    for (size_t i = 0; i < m_instances.size(); ++i) {
+        Instance& instance = m_instances[i];
+        const qint64 busy = instance.server->busyNanoseconds(), delta = busy - instance.lastBusyNs;
+
+        instance.lastBusyNs = busy;
+        threadBusy[instance.thread] += delta;
+        qInfo().nospace() << "match " << i << " (port " << instance.port << ", worker " << instance.thread << "): tick "
+            << instance.server->tickCount() << ", " << instance.server->clientCount() << " clients, cpu "
+            << QString::number(100.0 * delta / intervalNs, 'f', 2) << "%";
+    }
+
+    for (size_t t = 0; t < threadBusy.size(); ++t) {
+        qInfo().nospace() << "worker " << t << ": cpu " << QString::number(100.0 * threadBusy[t] / intervalNs, 'f', 2) << "%";
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef MATCHHOST_H
+#define MATCHHOST_H
+
+// Runs many independent GameServer instances in one process. Instances are
+// sharded round-robin over a fixed pool of worker threads; each one owns its
+// socket, timer and simulation and ticks on its own schedule, so nothing
+// mutable is shared between matches. Every few seconds the host logs how much
+// thread time each instance used.
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <vector>
+#include "GameServer.h"
+
+class MatchHost : public QObject {
+    Q_OBJECT
+public:
+    // instance i listens on config.port + i
+    MatchHost(const GameServer::Config& config, int instances, int threads, QObject* parent = nullptr);
+    ~MatchHost() override;
+    bool start();
+    int instanceCount() const;
+    quint16 instancePort(int idx) const;
+private slots:
+    void report();
+private:
+    struct Instance {
+        GameServer* server;
+        int thread;
+        quint16 port = 0;
+        qint64 lastBusyNs = 0;
+    };
+
+    GameServer::Config m_config;
+    std::vector<QThread*> m_threads;
+    std::vector<Instance> m_instances;
+    QTimer* m_reportTimer;
+    QElapsedTimer m_clock;
+    qint64 m_lastReportMs = 0;
+};
+
+#endif // MATCHHOST_H
@@ -1,108 +1,158 @@
 #include "MultiPlayerGameProcess.h"
+#include "SettingsWindow.h"
+#include <bit>
 
 MultiPlayerGameProcess::MultiPlayerGameProcess(QWidget *parent) : QDialog(parent) {
-    setFixedSize(800, 600);
+    setFixedSize(GridState::width * cell, GridState::height * cell);
     setFocusPolicy(Qt::StrongFocus);
     timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, &MultiPlayerGameProcess::updateGame);
-    startRound();
+    state.reset();
+    setupNetplay();
+
+    if (netplay) timer->start(50);
+    else startRound();
+}
+
+MultiPlayerGameProcess::~MultiPlayerGameProcess() { delete bot; }
+
+void MultiPlayerGameProcess::toggleBot() {
+    if (bot) {
+        delete bot;
+        bot = nullptr;
+    } else {
+        bot = new GridBot(1);
+
+        if (state.active) bot->start(state, botBudgetMs());
+    }
+
+    update();
+}
+
+int MultiPlayerGameProcess::botBudgetMs() const { return timer->interval() * 3 / 5; }
+
+void MultiPlayerGameProcess::setupNetplay() {
+    QJsonObject netplay_set = loadConfigRoot().value("netplay").toObject();
+
+    if (!netplay_set.value("enabled").toBool(false)) return;
+
+    RollbackSession::Config config;
+    config.localPlayer = netplay_set.value("local_player").toInt(1) - 1;
+    config.localPort = static_cast<quint16>(netplay_set.value("local_port").toInt(7788));
+    config.remoteHost = QHostAddress(netplay_set.value("remote_host").toString("127.0.0.1"));
+    config.remotePort = static_cast<quint16>(netplay_set.value("remote_port").toInt(7789));
+    config.inputDelay = netplay_set.value("input_delay").toInt(0);
+    netplay = new RollbackSession(config, this);
+
+    if (!netplay->start()) {
+        delete netplay;
+        netplay = nullptr;
+    }
 }
 
 void MultiPlayerGameProcess::paintEvent(QPaintEvent *) {
+    const GridState &s = netplay ? netplay->state() : state;
     QPainter p(this);
     p.fillRect(rect(), Qt::black);
-    drawBike(p, p1, Qt::cyan);
-    drawBike(p, p2, Qt::yellow);
+    drawBike(p, s, 0, Qt::cyan);
+    drawBike(p, s, 1, Qt::yellow);
 
-    if (!roundActive) {
+    if (bot) {
+        p.setPen(Qt::yellow);
+        p.setFont(QFont("Arial", 12));
+        p.drawText(rect().adjusted(0, 4, -8, 0), Qt::AlignTop | Qt::AlignRight, QString("P2: BOT (%1 playouts)").arg(bot->lastPlayouts()));
+    }
+
+    if (netplay && !netplay->isSynchronized()) {
         p.setPen(Qt::white);
         p.setFont(QFont("Arial", 20));
-        p.drawText(rect(), Qt::AlignCenter, QString("Round Over\nP1: %1  P2: %2\nPress Space").arg(p1Score).arg(p2Score));
+        p.drawText(rect(), Qt::AlignCenter, "Waiting for the other player");
+    } else if (!s.active) {
+        p.setPen(Qt::white);
+        p.setFont(QFont("Arial", 20));
+        p.drawText(rect(), Qt::AlignCenter, QString("Round Over\nP1: %1  P2: %2\n%3").arg(s.score[0]).arg(s.score[1]).arg(netplay ? "Next round starts shortly" : "Press Space, B toggles the bot"));
     }
 }
 
 void MultiPlayerGameProcess::keyPressEvent(QKeyEvent *e) {
-    if (!roundActive && e->key() == Qt::Key_Space) {
+    if (!netplay && !state.active && e->key() == Qt::Key_Space) {
         startRound();
 
         return;
     }
 
+    if (!netplay && e->key() == Qt::Key_B) {
+        toggleBot();
+
+        return;
+    }
+
     // Player 1
-    if (e->key() == Qt::Key_W) p1.dir = {0, -cell};
+    if (e->key() == Qt::Key_W) p1Turn = GridState::Up;
 
-    if (e->key() == Qt::Key_S) p1.dir = {0, cell};
+    if (e->key() == Qt::Key_S) p1Turn = GridState::Down;
 
-    if (e->key() == Qt::Key_A) p1.dir = {-cell, 0};
+    if (e->key() == Qt::Key_A) p1Turn = GridState::Left;
 
-    if (e->key() == Qt::Key_D) p1.dir = {cell, 0};
+    if (e->key() == Qt::Key_D) p1Turn = GridState::Right;
 
     // Player 2
-    if (e->key() == Qt::Key_Up) p2.dir = {0, -cell};
+    if (e->key() == Qt::Key_Up) p2Turn = GridState::Up;
 
-    if (e->key() == Qt::Key_Down) p2.dir = {0, cell};
+    if (e->key() == Qt::Key_Down) p2Turn = GridState::Down;
 
-    if (e->key() == Qt::Key_Left) p2.dir = {-cell, 0};
+    if (e->key() == Qt::Key_Left) p2Turn = GridState::Left;
 
-    if (e->key() == Qt::Key_Right) p2.dir = {cell, 0};
+    if (e->key() == Qt::Key_Right) p2Turn = GridState::Right;
 }
 
 void MultiPlayerGameProcess::updateGame() {
-    if (!roundActive) return;
+    if (netplay) {
+        // over the network both key sets steer our own bike; a stalled frame keeps the turn for the next one
+        quint8 turn = p1Turn != GridState::None ? p1Turn : p2Turn;
 
-    moveBike(p1);
-    moveBike(p2);
-    checkCollision(p1, p2);
-    checkCollision(p2, p1);
+        if (netplay->advance(turn)) p1Turn = p2Turn = GridState::None;
 
-    if (!p1.alive || !p2.alive) {
-        roundActive = false;
-        timer->stop();
+        update();
 
-        if (p1.alive) p1Score++;
-
-        if (p2.alive) p2Score++;
+        return;
     }
 
+    if (!state.active) return;
+
+    if (bot) p2Turn = bot->finish();
+
+    const quint8 input[2] = {p1Turn, p2Turn};
+
+    p1Turn = p2Turn = GridState::None;
+    state.step(input);
+
+    if (!state.active) timer->stop();
+    else if (bot) bot->start(state, botBudgetMs());
+
     update();
 }
 
 void MultiPlayerGameProcess::startRound() {
-    p1 = {{100, height()/2}, {cell, 0}};
-    p2 = {{width()-100, height()/2}, {-cell, 0}};
-    p1.trail.clear();
-    p2.trail.clear();
-    p1.alive = p2.alive = true;
-    roundActive = true;
+    state.startRound();
+    p1Turn = p2Turn = GridState::None;
     timer->start(50);
-    update();
-}
 
-void MultiPlayerGameProcess::moveBike(Bike &b) {
-    if (!b.alive) return;
+    if (bot) bot->start(state, botBudgetMs());
 
-    b.trail.insert(b.pos);
-    b.pos += b.dir;
+    update();
 }
 
-void MultiPlayerGameProcess::checkCollision(Bike &b, const Bike &other) {
-    if (!b.alive) return;
+void MultiPlayerGameProcess::drawBike(QPainter &p, const GridState &s, int player, QColor color) {
+    p.setPen(color);
 
-    // Wall collision
-    if (!rect().contains(b.pos)) {
-        b.alive = false;
+    for (int w = 0; w < GridState::words; ++w) {
+        for (quint64 bits = s.trail[player][w]; bits; bits &= bits - 1) {
+            const int idx = w * 64 + std::countr_zero(bits);
 
-        return;
+            p.drawRect((idx % GridState::width) * cell, (idx / GridState::width) * cell, cell, cell);
+        }
     }
 
-    // Trail collision
-    if (b.trail.contains(b.pos) || other.trail.contains(b.pos)) b.alive = false;
+    if (s.alive[player]) p.fillRect(s.x[player] * cell, s.y[player] * cell, cell, cell, color);
 }
-
-void MultiPlayerGameProcess::drawBike(QPainter &p, const Bike &b, QColor color) {
-    p.setPen(color);
-
-    for (const QPoint &pt : b.trail) p.drawRect(pt.x(), pt.y(), cell, cell);
-
-    if (b.alive) p.fillRect(b.pos.x(), b.pos.y(), cell, cell, color);
-}
\ No newline at end of file
@@ -6,25 +6,23 @@
 // Player 1: W A S D
 // Player 2: Arrow Keys
 // Top-down 2D view, multiple rounds, win/lose logic
+// With "netplay" enabled in the config each side drives one bike (either key set)
+// and the peers stay in sync through RollbackSession.
+// Offline, B hands player 2 to GridBot, which searches between ticks.
 
 #include <QWidget>
 #include <QDialog>
 #include <QPainter>
 #include <QKeyEvent>
 #include <QTimer>
-#include <QSet>
-
-struct Bike {
-    QPoint pos;
-    QPoint dir;
-    QSet<QPoint> trail;
-    bool alive = true;
-};
+#include "RollbackSession.h"
+#include "GridBot.h"
 
 class MultiPlayerGameProcess : public QDialog {
     Q_OBJECT
 public:
     explicit MultiPlayerGameProcess(QWidget *parent = nullptr);
+    ~MultiPlayerGameProcess() override;
 protected:
     void paintEvent(QPaintEvent *) override;
     void keyPressEvent(QKeyEvent *e) override;
@@ -33,18 +31,21 @@ private slots:
 private:
     const int cell = 5;
     QTimer *timer;
-    Bike p1, p2;
-    bool roundActive = false;
-    int p1Score = 0;
-    int p2Score = 0;
+    GridState state;
+    RollbackSession *netplay = nullptr;
+    GridBot *bot = nullptr;
+    quint8 p1Turn = GridState::None;
+    quint8 p2Turn = GridState::None;
 
     void startRound();
-    void moveBike(Bike &b);
-    void checkCollision(Bike &b, const Bike &other);
-    void drawBike(QPainter &p, const Bike &b, QColor color);
+    void setupNetplay();
+    void toggleBot();
+    // the bot thinks for most of the gap until the next tick
+    int botBudgetMs() const;
+    void drawBike(QPainter &p, const GridState &s, int player, QColor color);
 };
 
 // Usage:
 // Create a QApplication and set TronWidget as the main widget
 
-#endif // MULTIPLAYERGAMEPROCESS_H
\ No newline at end of file
+#endif // MULTIPLAYERGAMEPROCESS_H
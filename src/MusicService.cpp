@@ -0,0 +1,240 @@
+#include "MusicService.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QRandomGenerator>
+#include <QMediaDevices>
+#include <QUrl>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+PcmStream::PcmStream(QObject* parent) : QIODevice(parent) {}
+
+void PcmStream::append(const QByteArray& pcm, int track) {
+    if (pcm.isEmpty()) return;
+
+    QMutexLocker lock(&m_mutex);
+
+    m_chunks.push_back({pcm, 0, track});
+    m_buffered += pcm.size();
+}
+
+void PcmStream::dropTrack(int track) {
+    QMutexLocker lock(&m_mutex);
+
+    while (!m_chunks.empty() && m_chunks.front().track == track) {
+        m_buffered -= m_chunks.front().data.size() - m_chunks.front().offset;
+        m_chunks.pop_front();
+    }
+}
+
+void PcmStream::clear() {
+    QMutexLocker lock(&m_mutex);
+
+    m_chunks.clear();
+    m_buffered = 0;
+}
+
+void PcmStream::setSilence(char silence) {
+    QMutexLocker lock(&m_mutex);
+
+    m_silence = silence;
+}
+
+qint64 PcmStream::bufferedBytes() const {
+    QMutexLocker lock(&m_mutex);
+
+    return m_buffered;
+}
+
+int PcmStream::playingTrack() const {
+    QMutexLocker lock(&m_mutex);
+
+    return m_chunks.empty() ? m_playingTrack : m_chunks.front().track;
+}
+
+bool PcmStream::isSequential() const { return true; }
+
+qint64 PcmStream::readData(char* data, qint64 maxSize) {
+    QMutexLocker lock(&m_mutex);
+    qint64 written = 0;
+
+    while (written < maxSize && !m_chunks.empty()) {
+        Chunk& chunk = m_chunks.front();
+        qint64 n = std::min<qint64>(maxSize - written, chunk.data.size() - chunk.offset);
+
+        std::memcpy(data + written, chunk.data.constData() + chunk.offset, static_cast<size_t>(n));
+        chunk.offset += n;
+        written += n;
+        m_buffered -= n;
+        m_playingTrack = chunk.track;
+
+        if (chunk.offset >= chunk.data.size()) m_chunks.pop_front();
+    }
+
+    if (written < maxSize) {
+        std::memset(data + written, m_silence, static_cast<size_t>(maxSize - written));
+        written = maxSize;
+    }
+
+    return written;
+}
+
+qint64 PcmStream::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+MusicService* MusicService::instance() {
+    static MusicService* service = new MusicService(QCoreApplication::instance());
+
+    return service;
+}
+
+MusicService::MusicService(QObject* parent) : QObject(parent) {
+    m_format.setSampleRate(44100);
+    m_format.setChannelCount(2);
+    m_format.setSampleFormat(QAudioFormat::Int16);
+    m_stream = new PcmStream(this);
+    m_stream->open(QIODevice::ReadOnly);
+    m_decoder = new QAudioDecoder(this);
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &MusicService::onBufferReady);
+    connect(m_decoder, &QAudioDecoder::finished, this, &MusicService::onDecodeFinished);
+    connect(m_decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), this,
+        [this](QAudioDecoder::Error) {
+            // unreadable file: drop it from the playlist and keep the queue going
+            m_decoding = false;
+            m_decoder->stop();
+            m_playlist.removeAt(--m_playlistPos);
+            ++m_failedDecodes;
+
+            // every file failed in a row: a full pass found nothing playable, so stop trying
+            if (m_playlist.isEmpty()) {
+                qWarning() << "MusicService: none of the" << m_failedDecodes << "music files could be decoded, music is off";
+                m_refillTimer->stop();
+
+                return;
+            }
+
+            decodeNext();
+        }
+    );
+    m_refillTimer = new QTimer(this);
+    m_refillTimer->setInterval(500);
+    connect(m_refillTimer, &QTimer::timeout, this, &MusicService::onRefill);
+}
+
+void MusicService::scanPlaylist() {
+    QDir music_dir(QCoreApplication::applicationDirPath() + "/music");
+    const QStringList files = music_dir.entryList({"*.mp3", "*.ogg", "*.flac", "*.wav"}, QDir::Files);
+
+    m_playlist.clear();
+
+    for (const QString& file : files) m_playlist << music_dir.absoluteFilePath(file);
+
+    std::shuffle(m_playlist.begin(), m_playlist.end(), *QRandomGenerator::global());
+    m_playlistPos = 0;
+}
+
+void MusicService::play() {
+    if (m_playing) return;
+
+    if (!m_sink) {
+        scanPlaylist();
+
+        if (m_playlist.isEmpty()) return;
+
+        QAudioDevice device = QMediaDevices::defaultAudioOutput();
+
+        // the device can't take 44.1 kHz 16-bit stereo: play in its own format, the decoder converts to it
+        if (!device.isFormatSupported(m_format)) m_format = device.preferredFormat();
+
+        m_decoder->setAudioFormat(m_format);
+        m_stream->setSilence(m_format.sampleFormat() == QAudioFormat::UInt8 ? char(0x80) : char(0));
+        m_sink = new QAudioSink(device, m_format, this);
+        m_sink->setVolume(1.0);
+        decodeNext();
+        m_sink->start(m_stream);
+    } else m_sink->resume();
+
+    m_playing = true;
+    m_refillTimer->start();
+}
+
+void MusicService::pause() {
+    if (!m_playing) return;
+
+    m_playing = false;
+    m_refillTimer->stop();
+
+    if (m_sink) m_sink->suspend();
+}
+
+void MusicService::nextTrack() {
+    if (!m_sink) return;
+
+    const int track = m_stream->playingTrack();
+
+    m_stream->dropTrack(track);
+
+    // the skipped track may still be decoding, held back at the buffer-ahead limit
+    if (m_decoding && m_decodingTrack == track) {
+        m_decoding = false;
+        m_decoder->stop();
+    }
+
+    // the following track is usually queued already; otherwise start it right away
+    if (m_stream->bufferedBytes() == 0 && !m_decoding) decodeNext();
+}
+
+bool MusicService::isPlaying() const { return m_playing; }
+
+void MusicService::decodeNext() {
+    if (m_playlist.isEmpty() || m_decoding) return;
+
+    if (m_playlistPos >= m_playlist.size()) {
+        std::shuffle(m_playlist.begin(), m_playlist.end(), *QRandomGenerator::global());
+        m_playlistPos = 0;
+    }
+
+    m_decodingTrack = m_trackCounter++;
+    m_decoding = true;
+    m_decoder->setSource(QUrl::fromLocalFile(m_playlist[m_playlistPos++]));
+    m_decoder->start();
+}
+
+qint64 MusicService::queuedMs() const {
+    return m_format.durationForBytes(static_cast<qint32>(std::min<qint64>(m_stream->bufferedBytes(), INT32_MAX))) / 1000;
+}
+
+void MusicService::onBufferReady() {
+    // far enough ahead: leave the buffer unread, which keeps the decoder from producing more; onRefill picks it up
+    if (queuedMs() >= m_bufferAheadMs) return;
+
+    QAudioBuffer buffer = m_decoder->read();
+
+    if (!buffer.isValid()) return;
+
+    m_failedDecodes = 0;
+    m_stream->append(QByteArray(buffer.constData<char>(), static_cast<qsizetype>(buffer.byteCount())), m_decodingTrack);
+}
+
+void MusicService::onDecodeFinished() {
+    m_decoding = false;
+    m_decoder->stop();
+    onRefill();
+}
+
+void MusicService::onRefill() {
+    if (m_decoding) {
+        // resume a decode held back in onBufferReady once playback has drained the queue
+        if (m_decoder->bufferAvailable()) onBufferReady();
+
+        return;
+    }
+
+    if (queuedMs() < m_prefetchMs) decodeNext();
+}
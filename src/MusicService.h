@@ -0,0 +1,87 @@
+#ifndef MUSICSERVICE_H
+#define MUSICSERVICE_H
+
+// Shared background music for the menu and the game.
+// One QAudioSink stays open for the whole session and pulls PCM from a queue
+// that QAudioDecoder fills in the background, a few seconds ahead of playback.
+// The next track is decoded and appended to the same queue before the current
+// one runs out, so tracks switch without a gap and screen transitions never
+// reopen the audio device.
+
+#include <QObject>
+#include <QIODevice>
+#include <QMutex>
+#include <QStringList>
+#include <QAudioFormat>
+#include <QAudioSink>
+#include <QAudioDecoder>
+#include <QTimer>
+#include <deque>
+
+// sequential device the audio sink pulls from; plays silence on underrun instead of going idle
+class PcmStream : public QIODevice {
+public:
+    explicit PcmStream(QObject* parent = nullptr);
+    void append(const QByteArray& pcm, int track);
+    void dropTrack(int track);
+    void clear();
+    // byte written on underrun; zero except for unsigned 8-bit output
+    void setSilence(char silence);
+    qint64 bufferedBytes() const;
+    int playingTrack() const;
+    bool isSequential() const override;
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+private:
+    struct Chunk {
+        QByteArray data;
+        qint64 offset;
+        int track;
+    };
+
+    mutable QMutex m_mutex;
+    std::deque<Chunk> m_chunks;
+    qint64 m_buffered = 0;
+    int m_playingTrack = -1;
+    char m_silence = 0;
+};
+
+class MusicService : public QObject {
+    Q_OBJECT
+public:
+    static MusicService* instance();
+    void play();
+    void pause();
+    void nextTrack();
+    bool isPlaying() const;
+private slots:
+    void onBufferReady();
+    void onDecodeFinished();
+    void onRefill();
+private:
+    explicit MusicService(QObject* parent = nullptr);
+    void scanPlaylist();
+    void decodeNext();
+    qint64 queuedMs() const;
+
+    QAudioFormat m_format;
+    QAudioSink* m_sink = nullptr;
+    PcmStream* m_stream = nullptr;
+    QAudioDecoder* m_decoder = nullptr;
+    QTimer* m_refillTimer = nullptr;
+    QStringList m_playlist;
+    int m_playlistPos = 0;
+    int m_decodingTrack = -1;
+    int m_trackCounter = 0;
+    // decoder errors since the last good buffer
+    int m_failedDecodes = 0;
+    bool m_decoding = false;
+    bool m_playing = false;
+    // the next track starts decoding once less than this much audio is queued
+    int m_prefetchMs = 15000;
+    // decoding holds back once this much audio is queued, so a track is never decoded whole
+    int m_bufferAheadMs = 20000;
+};
+
+#endif // MUSICSERVICE_H
@@ -0,0 +1,340 @@
+#include "NetClient.h"
+#include <QNetworkDatagram>
+
+namespace {
+
+const int helloRetryMs = 500;
+const size_t maxPendingInputs = 128;
+const size_t maxSamples = 32;
+// per-tick decay of the visual offset left behind by a reconciliation
+const float correctionDecay = 0.85f;
+// errors larger than this are teleports (respawn, missed collision) and are not smoothed
+const float snapDistance = 5.0f;
+
+}
+
+NetClient::NetClient(QObject* parent) : QObject(parent) {
+    m_socket = new QUdpSocket(this);
+    m_sendTimer = new QTimer(this);
+    m_sendTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_socket, &QUdpSocket::readyRead, this, &NetClient::onReadyRead);
+    connect(m_sendTimer, &QTimer::timeout, this, &NetClient::onSendTick);
+}
+
+void NetClient::connectToServer(const QHostAddress& host, quint16 port, const QString& name) {
+    m_host = host;
+    m_port = port;
+    m_name = name;
+    m_connected = false;
+    m_lastTick = NetProtocol::noBaseline;
+    m_socket->bind(QHostAddress::AnyIPv4, 0);
+    // until the server welcomes us the send timer just repeats the hello
+    m_sendTimer->start(helloRetryMs);
+    onSendTick();
+}
+
+void NetClient::disconnectFromServer() {
+    if (m_connected) m_socket->writeDatagram(NetProtocol::encodeBye(), m_host, m_port);
+
+    m_connected = false;
+    m_sendTimer->stop();
+}
+
+void NetClient::setTurnInput(float turn) { m_turn = turn; }
+
+void NetClient::setInterpolationDelay(int ms) { m_interpDelayMs = std::max(0, ms); }
+
+void NetClient::setViewYaw(float yaw) {
+    m_viewYaw = yaw;
+    m_viewYawSet = true;
+}
+
+bool NetClient::isConnected() const { return m_connected; }
+
+int NetClient::slot() const { return m_slot; }
+
+int NetClient::round() const { return m_round; }
+
+const std::vector<NetClient::RemoteBike>& NetClient::bikes() const { return m_bikes; }
+
+const std::vector<std::deque<QVector3D>>& NetClient::trails() const { return m_trails; }
+
+qint64 NetClient::bytesReceived() const { return m_bytesReceived; }
+
+float NetClient::lastCorrection() const { return m_lastCorrection; }
+
+NetClient::RemoteBike NetClient::localBike() const {
+    RemoteBike r;
+    r.pos = m_predicted.pos + m_correction;
+    r.yaw = m_predicted.yaw;
+    r.speed = m_predicted.speed;
+    r.alive = m_predictedValid && m_predicted.alive;
+    r.human = true;
+
+    return r;
+}
+
+double NetClient::serverTickNow() const {
+    return (static_cast<double>(m_clock.elapsed()) - m_tickClockOffset) * m_tickRate / 1000.0;
+}
+
+std::vector<NetClient::RemoteBike> NetClient::renderBikes() const {
+    std::vector<RemoteBike> out = m_bikes;
+
+    if (!m_samples.empty()) {
+        const double t = serverTickNow() - m_interpDelayMs * m_tickRate / 1000.0;
+        size_t i = 0;
+
+        while (i + 1 < m_samples.size() && m_samples[i + 1].tick <= t) ++i;
+
+        const Sample& a = m_samples[i];
+
+        // past either end of the buffer we hold the nearest snapshot rather than extrapolate
+        if (i + 1 >= m_samples.size() || t <= a.tick || a.bikes.size() != m_samples[i + 1].bikes.size()) out = a.bikes;
+        else {
+            const Sample& b = m_samples[i + 1];
+            const float f = static_cast<float>((t - a.tick) / (b.tick - a.tick));
+
+            out.resize(a.bikes.size());
+
+            for (size_t k = 0; k < a.bikes.size(); ++k) {
+                const RemoteBike& from = a.bikes[k];
+                const RemoteBike& to = b.bikes[k];
+                RemoteBike& r = out[k];
+
+                r.pos = from.pos + (to.pos - from.pos) * f;
+                r.yaw = GameSimulation::wrapPi(from.yaw + GameSimulation::wrapPi(to.yaw - from.yaw) * f);
+                r.speed = from.speed + (to.speed - from.speed) * f;
+                r.alive = from.alive;
+                r.human = from.human;
+            }
+        }
+    }
+
+    if (m_predictedValid && m_slot >= 0 && m_slot < static_cast<int>(out.size())) out[m_slot] = localBike();
+
+    return out;
+}
+
+void NetClient::onSendTick() {
+    using namespace NetProtocol;
+
+    if (!m_connected) {
+        m_socket->writeDatagram(encodeHello({m_name}), m_host, m_port);
+
+        return;
+    }
+
+    InputPacket input;
+    input.seq = ++m_inputSeq;
+    input.ackTick = m_lastTick;
+    input.turn = quantizeTurn(m_turn);
+    input.viewYaw = quantizeYaw(m_viewYawSet ? m_viewYaw : m_predicted.yaw);
+    m_socket->writeDatagram(encodeInput(input), m_host, m_port);
+
+    // predict with the exact value the server will see after quantization
+    m_pending.push_back({input.seq, dequantizeTurn(input.turn)});
+
+    while (m_pending.size() > maxPendingInputs) m_pending.pop_front();
+
+    if (m_predictedValid && m_predicted.alive) {
+        m_predicted.turnInput = m_pending.back().turn;
+        m_model.advanceBike(m_predicted, 1.0f / static_cast<float>(m_tickRate));
+    }
+
+    m_correction *= correctionDecay;
+}
+
+void NetClient::onReadyRead() {
+    using namespace NetProtocol;
+
+    while (m_socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_socket->receiveDatagram();
+        QByteArray data = datagram.data();
+        QDataStream in(data);
+        PacketType type;
+
+        m_bytesReceived += data.size();
+
+        if (!readHeader(in, type)) continue;
+
+        if (type == Welcome) handleWelcome(in);
+        else if (type == Snapshot && m_connected) handleSnapshot(in);
+    }
+}
+
+void NetClient::handleWelcome(QDataStream& in) {
+    NetProtocol::WelcomePacket welcome;
+
+    if (!NetProtocol::decodeWelcome(in, welcome) || m_connected) return;
+
+    m_connected = true;
+    m_slot = welcome.slot;
+    m_tickRate = std::max<int>(1, welcome.tickRate);
+    m_halfSize = welcome.mapHalfSize;
+    m_maxSpeed = welcome.maxSpeed;
+    m_model.setFieldSize(welcome.fieldSize);
+    m_pending.clear();
+    m_samples.clear();
+    m_predictedValid = false;
+    m_clockSynced = false;
+    m_clock.start();
+    m_sendTimer->start(std::max(1, 1000 / m_tickRate));
+    emit connected(m_slot);
+}
+
+void NetClient::handleSnapshot(QDataStream& in) {
+    using namespace NetProtocol;
+
+    SnapshotPacket p;
+
+    if (!decodeSnapshotHeader(in, p)) return;
+
+    // late datagrams of the current round are useless once a newer tick was applied
+    if (m_lastTick != noBaseline && p.round == m_round && p.tick <= m_lastTick) return;
+
+    const Frame* base = nullptr;
+
+    if (p.baseTick != noBaseline) {
+        const Frame& candidate = m_history[p.baseTick % historySize];
+
+        if (candidate.tick != p.baseTick) return;
+
+        base = &candidate;
+    }
+
+    if (!decodeSnapshotBody(in, base, p)) return;
+
+    const size_t n = p.bikes.size();
+
+    if (p.round != m_round || m_trails.size() != n) {
+        m_round = p.round;
+        m_trails.assign(n, {});
+        m_trailHead.assign(n, 0);
+        m_trailCoarse.assign(n, false);
+        m_samples.clear();
+        m_predictedValid = false;
+        m_correction = QVector3D();
+    }
+
+    m_bikes.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        const BikeState& q = p.bikes[i];
+        RemoteBike& b = m_bikes[i];
+
+        b.pos = QVector3D(dequantizeCoord(q.x, m_halfSize), 0.0f, dequantizeCoord(q.z, m_halfSize));
+        b.yaw = dequantizeYaw(q.yaw);
+        b.speed = dequantizeSpeed(q.speed, m_maxSpeed);
+        b.alive = q.flags & Alive;
+        b.human = q.flags & Human;
+
+        std::deque<QVector3D>& trail = m_trails[i];
+        const TrailSummary& summary = p.summaries[i];
+        const TrailAppend& a = p.appends[i];
+
+        // far trails arrive as a few points that replace the previous ones outright
+        if (!summary.cells.empty()) {
+            trail.clear();
+            m_trailCoarse[i] = true;
+
+            for (const TrailCell& cell : summary.cells) trail.push_back(QVector3D(dequantizeCoord(cell.x, m_halfSize), 0.0f, dequantizeCoord(cell.z, m_halfSize)));
+
+            continue;
+        }
+
+        if (m_trailCoarse[i]) {
+            if (a.cells.empty()) continue;
+
+            // back in range: the server restarts the exact trail from its current head
+            trail.clear();
+            m_trailCoarse[i] = false;
+            m_trailHead[i] = a.from;
+        }
+
+        while (!trail.empty() && m_trailHead[i] < p.trailHead[i]) {
+            trail.pop_front();
+            ++m_trailHead[i];
+        }
+
+        if (trail.empty()) m_trailHead[i] = std::max(m_trailHead[i], p.trailHead[i]);
+
+        for (size_t k = 0; k < a.cells.size(); ++k) {
+            const quint32 idx = a.from + static_cast<quint32>(k), end = m_trailHead[i] + static_cast<quint32>(trail.size());
+
+            if (idx < end || idx < m_trailHead[i]) continue;
+
+            // a hole means we missed points we can't recover; restart the trail from here
+            if (idx > end) {
+                trail.clear();
+                m_trailHead[i] = idx;
+            }
+
+            trail.push_back(QVector3D(dequantizeCoord(a.cells[k].x, m_halfSize), 0.0f, dequantizeCoord(a.cells[k].z, m_halfSize)));
+        }
+    }
+
+    Frame& f = m_history[p.tick % historySize];
+    f.tick = p.tick;
+    f.round = p.round;
+    f.bikes = p.bikes;
+    f.trailHead = p.trailHead;
+    f.trailEnd.resize(n);
+
+    for (size_t i = 0; i < n; ++i) f.trailEnd[i] = m_trailHead[i] + static_cast<quint32>(m_trails[i].size());
+
+    m_lastTick = p.tick;
+
+    // the fastest delivery seen so far is the best estimate of the server clock; later ones only nudge it
+    const double offset = static_cast<double>(m_clock.elapsed()) - p.tick * 1000.0 / m_tickRate;
+
+    if (!m_clockSynced || offset < m_tickClockOffset) m_tickClockOffset = offset;
+    else m_tickClockOffset += (offset - m_tickClockOffset) * 0.02;
+
+    m_clockSynced = true;
+    m_samples.push_back({p.tick, m_bikes});
+
+    while (m_samples.size() > maxSamples) m_samples.pop_front();
+
+    reconcile(p);
+    emit snapshotApplied(p.tick);
+}
+
+void NetClient::reconcile(const NetProtocol::SnapshotPacket& p) {
+    using namespace NetProtocol;
+
+    if (m_slot < 0 || m_slot >= static_cast<int>(p.bikes.size())) return;
+
+    while (!m_pending.empty() && m_pending.front().seq <= p.ackInputSeq) m_pending.pop_front();
+
+    const BikeState& q = p.bikes[m_slot];
+    const float dt = 1.0f / static_cast<float>(m_tickRate);
+    GameSimulation::Bike b{};
+
+    b.pos = b.prevPos = b.currPos = QVector3D(dequantizeCoord(q.x, m_halfSize), 0.0f, dequantizeCoord(q.z, m_halfSize));
+    b.yaw = dequantizeYaw(q.yaw);
+    b.speed = dequantizeSpeed(q.speed, m_maxSpeed);
+    b.alive = q.flags & Alive;
+    b.human = true;
+
+    if (b.alive) {
+        for (const PendingInput& input : m_pending) {
+            b.turnInput = input.turn;
+            m_model.advanceBike(b, dt);
+        }
+    }
+
+    // keep what is on screen where it was and let the difference fade out over a few ticks
+    if (m_predictedValid && m_predicted.alive && b.alive) {
+        const QVector3D shown = m_predicted.pos + m_correction;
+
+        m_lastCorrection = (m_predicted.pos - b.pos).length();
+        m_correction = (shown - b.pos).length() > snapDistance ? QVector3D() : shown - b.pos;
+    } else {
+        m_lastCorrection = 0.0f;
+        m_correction = QVector3D();
+    }
+
+    m_predicted = b;
+    m_predictedValid = true;
+}
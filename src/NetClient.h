@@ -0,0 +1,110 @@
+#ifndef NETCLIENT_H
+#define NETCLIENT_H
+
+// UDP client for GameServer: sends the local turn input every tick and rebuilds
+// the arena from delta snapshots. Acks the newest applied snapshot so the server
+// can diff the next one against it.
+// The local bike is predicted with the shared GameSimulation movement code and
+// reconciled by replaying unacknowledged inputs on top of each authoritative
+// state; remote bikes are drawn interpolated a little behind the newest snapshot.
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector3D>
+#include <array>
+#include <deque>
+#include <vector>
+#include "NetProtocol.h"
+#include "GameSimulation.h"
+
+class NetClient : public QObject {
+    Q_OBJECT
+public:
+    struct RemoteBike {
+        QVector3D pos;
+        float yaw = 0.0f;
+        float speed = 0.0f;
+        bool alive = false;
+        bool human = false;
+    };
+
+    explicit NetClient(QObject* parent = nullptr);
+    void connectToServer(const QHostAddress& host, quint16 port, const QString& name);
+    void disconnectFromServer();
+    void setTurnInput(float turn);
+    void setInterpolationDelay(int ms);
+    // camera heading sent to the server for interest management; defaults to the bike's heading
+    void setViewYaw(float yaw);
+    bool isConnected() const;
+    int slot() const;
+    int round() const;
+    // newest authoritative state, no smoothing
+    const std::vector<RemoteBike>& bikes() const;
+    // what to draw right now: remote bikes interpolated, our own bike predicted
+    std::vector<RemoteBike> renderBikes() const;
+    RemoteBike localBike() const;
+    // distance between prediction and the replayed authoritative state at the last snapshot
+    float lastCorrection() const;
+    const std::vector<std::deque<QVector3D>>& trails() const;
+    qint64 bytesReceived() const;
+signals:
+    void connected(int slot);
+    void snapshotApplied(quint32 tick);
+private slots:
+    void onReadyRead();
+    void onSendTick();
+private:
+    void handleWelcome(QDataStream& in);
+    void handleSnapshot(QDataStream& in);
+    void reconcile(const NetProtocol::SnapshotPacket& p);
+    double serverTickNow() const;
+
+    struct PendingInput {
+        quint32 seq;
+        float turn;
+    };
+
+    struct Sample {
+        quint32 tick;
+        std::vector<RemoteBike> bikes;
+    };
+
+    QUdpSocket* m_socket;
+    QTimer* m_sendTimer;
+    QHostAddress m_host;
+    quint16 m_port = 0;
+    QString m_name;
+    bool m_connected = false;
+    int m_slot = -1;
+    int m_round = -1;
+    int m_tickRate = 60;
+    float m_halfSize = 1.0f;
+    float m_maxSpeed = 1.0f;
+    float m_turn = 0.0f;
+    float m_viewYaw = 0.0f;
+    bool m_viewYawSet = false;
+    quint32 m_inputSeq = 0;
+    quint32 m_lastTick = NetProtocol::noBaseline;
+    std::array<NetProtocol::Frame, NetProtocol::historySize> m_history;
+    std::vector<RemoteBike> m_bikes;
+    std::vector<std::deque<QVector3D>> m_trails;
+    std::vector<quint32> m_trailHead;
+    std::vector<bool> m_trailCoarse;
+    qint64 m_bytesReceived = 0;
+    GameSimulation m_model;
+    GameSimulation::Bike m_predicted{};
+    bool m_predictedValid = false;
+    std::deque<PendingInput> m_pending;
+    QVector3D m_correction;
+    float m_lastCorrection = 0.0f;
+    QElapsedTimer m_clock;
+    double m_tickClockOffset = 0.0;
+    bool m_clockSynced = false;
+    int m_interpDelayMs = 100;
+    std::deque<Sample> m_samples;
+};
+
+#endif // NETCLIENT_H
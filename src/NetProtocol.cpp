@@ -0,0 +1,274 @@
+#include "NetProtocol.h"
+#include <algorithm>
+#include <functional>
+
+namespace NetProtocol {
+
+namespace {
+
+enum BikeField : quint8 {
+    FieldPos = 1,
+    FieldYaw = 2,
+    FieldSpeed = 4,
+    FieldFlags = 8
+};
+
+void writeBits(QDataStream& out, const std::vector<bool>& bits) {
+    for (size_t i = 0; i < bits.size(); i += 8) {
+        quint8 byte = 0;
+
+        for (size_t b = 0; b < 8 && i + b < bits.size(); ++b) if (bits[i + b]) byte |= quint8(1u << b);
+
+        out << byte;
+    }
+}
+
+std::vector<bool> readBits(QDataStream& in, size_t count) {
+    std::vector<bool> bits(count, false);
+
+    for (size_t i = 0; i < count; i += 8) {
+        quint8 byte = 0;
+        in >> byte;
+
+        for (size_t b = 0; b < 8 && i + b < count; ++b) bits[i + b] = (byte >> b) & 1u;
+    }
+
+    return bits;
+}
+
+QByteArray packet(PacketType type, const std::function<void(QDataStream&)>& body) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    writeHeader(out, type);
+    body(out);
+
+    return data;
+}
+
+}
+
+qint16 quantizeCoord(float v, float halfSize) {
+    float n = std::clamp(v / halfSize, -1.0f, 1.0f);
+
+    return static_cast<qint16>(std::lround(n * 32767.0f));
+}
+
+float dequantizeCoord(qint16 q, float halfSize) { return static_cast<float>(q) / 32767.0f * halfSize; }
+
+quint16 quantizeYaw(float yaw) {
+    const float twoPi = 2.0f * static_cast<float>(M_PI);
+    float n = std::fmod(yaw + static_cast<float>(M_PI), twoPi);
+
+    if (n < 0.0f) n += twoPi;
+
+    return static_cast<quint16>(static_cast<quint32>(std::lround(n / twoPi * 65536.0f)) & 0xFFFFu);
+}
+
+float dequantizeYaw(quint16 q) { return static_cast<float>(q) / 65536.0f * 2.0f * static_cast<float>(M_PI) - static_cast<float>(M_PI); }
+
+quint8 quantizeSpeed(float speed, float maxSpeed) {
+    if (maxSpeed <= 0.0f) return 0;
+
+    return static_cast<quint8>(std::lround(std::clamp(speed / maxSpeed, 0.0f, 1.0f) * 255.0f));
+}
+
+float dequantizeSpeed(quint8 q, float maxSpeed) { return static_cast<float>(q) / 255.0f * maxSpeed; }
+
+qint8 quantizeTurn(float turn) { return static_cast<qint8>(std::lround(std::clamp(turn, -1.0f, 1.0f) * 127.0f)); }
+
+float dequantizeTurn(qint8 q) { return static_cast<float>(q) / 127.0f; }
+
+void writeHeader(QDataStream& out, PacketType type) { out << magic << version << static_cast<quint8>(type); }
+
+bool readHeader(QDataStream& in, PacketType& type) {
+    quint16 m = 0;
+    quint8 v = 0, t = 0;
+
+    in >> m >> v >> t;
+
+    if (in.status() != QDataStream::Ok || m != magic || v != version) return false;
+
+    type = static_cast<PacketType>(t);
+
+    return true;
+}
+
+QByteArray encodeHello(const HelloPacket& p) { return packet(Hello, [&](QDataStream& out) { out << p.name; }); }
+
+QByteArray encodeWelcome(const WelcomePacket& p) { return packet(Welcome, [&](QDataStream& out) { out << p.slot << p.fieldSize << p.tickRate << p.mapHalfSize << p.maxSpeed; }); }
+
+QByteArray encodeInput(const InputPacket& p) { return packet(Input, [&](QDataStream& out) { out << p.seq << p.ackTick << p.turn << p.viewYaw; }); }
+
+QByteArray encodeBye() { return packet(Bye, [](QDataStream&) {}); }
+
+bool decodeHello(QDataStream& in, HelloPacket& p) {
+    in >> p.name;
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool decodeWelcome(QDataStream& in, WelcomePacket& p) {
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    in >> p.slot >> p.fieldSize >> p.tickRate >> p.mapHalfSize >> p.maxSpeed;
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool decodeInput(QDataStream& in, InputPacket& p) {
+    in >> p.seq >> p.ackTick >> p.turn >> p.viewYaw;
+
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray encodeSnapshot(const Frame& cur, const Frame* base, quint32 ackInputSeq, const std::vector<TrailAppend>& appends, const std::vector<TrailSummary>& summaries) {
+    const size_t n = cur.bikes.size();
+
+    // a baseline from another round or with a different roster can't be diffed against
+    if (base && (base->round != cur.round || base->bikes.size() != n)) base = nullptr;
+
+    return packet(Snapshot, [&](QDataStream& out) {
+        out << cur.tick << (base ? base->tick : noBaseline) << cur.round << ackInputSeq << static_cast<quint16>(n);
+
+        std::vector<bool> changed(n), headChanged(n), hasAppend(n), hasSummary(n);
+
+        for (size_t i = 0; i < n; ++i) {
+            changed[i] = !base || !(base->bikes[i] == cur.bikes[i]);
+            headChanged[i] = !base || base->trailHead[i] != cur.trailHead[i];
+            hasAppend[i] = i < appends.size() && !appends[i].cells.empty();
+            hasSummary[i] = i < summaries.size() && !summaries[i].cells.empty();
+        }
+
+        writeBits(out, changed);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (!changed[i]) continue;
+
+            const BikeState& c = cur.bikes[i];
+            quint8 mask = 0;
+
+            if (!base || c.x != base->bikes[i].x || c.z != base->bikes[i].z) mask |= FieldPos;
+
+            if (!base || c.yaw != base->bikes[i].yaw) mask |= FieldYaw;
+
+            if (!base || c.speed != base->bikes[i].speed) mask |= FieldSpeed;
+
+            if (!base || c.flags != base->bikes[i].flags) mask |= FieldFlags;
+
+            out << mask;
+
+            if (mask & FieldPos) out << c.x << c.z;
+
+            if (mask & FieldYaw) out << c.yaw;
+
+            if (mask & FieldSpeed) out << c.speed;
+
+            if (mask & FieldFlags) out << c.flags;
+        }
+
+        writeBits(out, headChanged);
+
+        for (size_t i = 0; i < n; ++i) if (headChanged[i]) out << cur.trailHead[i];
+
+        writeBits(out, hasAppend);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (!hasAppend[i]) continue;
+
+            const size_t cells = std::min<size_t>(appends[i].cells.size(), 0xFFFF);
+
+            out << appends[i].from << static_cast<quint16>(cells);
+
+            for (size_t k = 0; k < cells; ++k) out << appends[i].cells[k].x << appends[i].cells[k].z;
+        }
+
+        writeBits(out, hasSummary);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (!hasSummary[i]) continue;
+
+            out << static_cast<quint8>(std::min<size_t>(summaries[i].cells.size(), 255));
+
+            for (size_t k = 0; k < summaries[i].cells.size() && k < 255; ++k) out << summaries[i].cells[k].x << summaries[i].cells[k].z;
+        }
+    });
+}
+
+bool decodeSnapshotHeader(QDataStream& in, SnapshotPacket& p) {
+    in >> p.tick >> p.baseTick >> p.round >> p.ackInputSeq;
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool decodeSnapshotBody(QDataStream& in, const Frame* base, SnapshotPacket& p) {
+    quint16 count = 0;
+    in >> count;
+
+    if (in.status() != QDataStream::Ok) return false;
+
+    const size_t n = count;
+
+    if (p.baseTick != noBaseline && (!base || base->tick != p.baseTick || base->bikes.size() != n)) return false;
+
+    if (p.baseTick == noBaseline) base = nullptr;
+
+    p.bikes = base ? base->bikes : std::vector<BikeState>(n);
+    p.trailHead = base ? base->trailHead : std::vector<quint32>(n, 0);
+    p.bikeChanged = readBits(in, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!p.bikeChanged[i]) continue;
+
+        BikeState& b = p.bikes[i];
+        quint8 mask = 0;
+
+        in >> mask;
+
+        if (mask & FieldPos) in >> b.x >> b.z;
+
+        if (mask & FieldYaw) in >> b.yaw;
+
+        if (mask & FieldSpeed) in >> b.speed;
+
+        if (mask & FieldFlags) in >> b.flags;
+    }
+
+    std::vector<bool> headChanged = readBits(in, n);
+
+    for (size_t i = 0; i < n; ++i) if (headChanged[i]) in >> p.trailHead[i];
+
+    std::vector<bool> hasAppend = readBits(in, n);
+
+    p.appends.assign(n, TrailAppend{});
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!hasAppend[i]) continue;
+
+        quint16 cells = 0;
+
+        in >> p.appends[i].from >> cells;
+        p.appends[i].cells.resize(cells);
+
+        for (TrailCell& cell : p.appends[i].cells) in >> cell.x >> cell.z;
+    }
+
+    std::vector<bool> hasSummary = readBits(in, n);
+
+    p.summaries.assign(n, TrailSummary{});
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!hasSummary[i]) continue;
+
+        quint8 cells = 0;
+
+        in >> cells;
+        p.summaries[i].cells.resize(cells);
+
+        for (TrailCell& cell : p.summaries[i].cells) in >> cell.x >> cell.z;
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+}
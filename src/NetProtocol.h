@@ -0,0 +1,136 @@
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+// Wire format shared by the dedicated server and its clients.
+// Every datagram starts with a magic, a protocol version and a packet type.
+// Bike transforms are quantized (16-bit arena-relative X/Z and yaw, 8-bit speed)
+// and snapshots are delta-compressed against the last snapshot the client acked:
+// unchanged bikes cost one bit, and trails only carry new points plus the new
+// expiry head, addressed by absolute point index so re-applying them is harmless.
+// Trails of bikes outside a client's area of interest travel as short coarse
+// summaries that replace whatever the client had for that trail.
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+#include <vector>
+#include <cmath>
+
+namespace NetProtocol {
+
+constexpr quint16 magic = 0x4C54; // "LT"
+constexpr quint8 version = 2;
+constexpr quint32 noBaseline = 0xFFFFFFFFu;
+constexpr int historySize = 64;
+
+enum PacketType : quint8 {
+    Hello = 1,
+    Welcome,
+    Input,
+    Snapshot,
+    Bye
+};
+
+struct BikeState {
+    qint16 x = 0;
+    qint16 z = 0;
+    quint16 yaw = 0;
+    quint8 speed = 0;
+    quint8 flags = 0;
+
+    bool operator==(const BikeState& o) const = default;
+};
+
+enum BikeFlag : quint8 {
+    Alive = 1,
+    Human = 2
+};
+
+struct TrailCell {
+    qint16 x;
+    qint16 z;
+};
+
+// quantized world as of one server tick; trail points are addressed by absolute index
+struct Frame {
+    quint32 tick = 0;
+    quint16 round = 0;
+    std::vector<BikeState> bikes;
+    std::vector<quint32> trailHead;
+    std::vector<quint32> trailEnd;
+};
+
+struct HelloPacket {
+    QString name;
+};
+
+struct WelcomePacket {
+    quint16 slot = 0;
+    quint16 fieldSize = 0;
+    quint16 tickRate = 0;
+    float mapHalfSize = 0.0f;
+    float maxSpeed = 0.0f;
+};
+
+struct InputPacket {
+    quint32 seq = 0;
+    quint32 ackTick = noBaseline;
+    qint8 turn = 0;
+    // camera heading, used by the server to prioritise what is in view
+    quint16 viewYaw = 0;
+};
+
+qint16 quantizeCoord(float v, float halfSize);
+float dequantizeCoord(qint16 q, float halfSize);
+quint16 quantizeYaw(float yaw);
+float dequantizeYaw(quint16 q);
+quint8 quantizeSpeed(float speed, float maxSpeed);
+float dequantizeSpeed(quint8 q, float maxSpeed);
+qint8 quantizeTurn(float turn);
+float dequantizeTurn(qint8 q);
+
+void writeHeader(QDataStream& out, PacketType type);
+// checks magic and version; returns false for foreign or truncated datagrams
+bool readHeader(QDataStream& in, PacketType& type);
+
+QByteArray encodeHello(const HelloPacket& p);
+QByteArray encodeWelcome(const WelcomePacket& p);
+QByteArray encodeInput(const InputPacket& p);
+QByteArray encodeBye();
+bool decodeHello(QDataStream& in, HelloPacket& p);
+bool decodeWelcome(QDataStream& in, WelcomePacket& p);
+bool decodeInput(QDataStream& in, InputPacket& p);
+
+// trail points the receiver does not have yet, per bike, starting at Frame::trailEnd of the baseline
+struct TrailAppend {
+    quint32 from = 0;
+    std::vector<TrailCell> cells;
+};
+
+// a handful of points standing in for a far-away trail; an empty one is not sent
+struct TrailSummary {
+    std::vector<TrailCell> cells;
+};
+
+// snapshot body: `base` may be null for a full snapshot
+QByteArray encodeSnapshot(const Frame& cur, const Frame* base, quint32 ackInputSeq, const std::vector<TrailAppend>& appends, const std::vector<TrailSummary>& summaries);
+
+struct SnapshotPacket {
+    quint32 tick = 0;
+    quint32 baseTick = noBaseline;
+    quint16 round = 0;
+    quint32 ackInputSeq = 0;
+    std::vector<BikeState> bikes;
+    std::vector<bool> bikeChanged;
+    std::vector<quint32> trailHead;
+    std::vector<TrailAppend> appends;
+    std::vector<TrailSummary> summaries;
+};
+
+// the header names the baseline; the receiver looks it up before decoding the body against it
+bool decodeSnapshotHeader(QDataStream& in, SnapshotPacket& p);
+bool decodeSnapshotBody(QDataStream& in, const Frame* base, SnapshotPacket& p);
+
+}
+
+#endif // NETPROTOCOL_H
@@ -0,0 +1,154 @@
+#include "OccupancyGrid.h"
+#include <algorithm>
+#include <bit>
+
+void OccupancyGrid::resize(int width, int height) {
+    m_width = std::max(1, width);
+    m_height = std::max(1, height);
+    m_rowWords = (m_width + 63) / 64;
+
+    const size_t words = static_cast<size_t>(m_rowWords) * (m_height + 2);
+
+    m_blocked.assign(words, 0);
+    m_free.assign(words, 0);
+
+    for (Bits* scratch : {&m_a, &m_b, &m_c, &m_d, &m_claimed}) scratch->assign(words, 0);
+
+    clear();
+}
+
+void OccupancyGrid::clear() {
+    std::fill(m_blocked.begin(), m_blocked.end(), 0);
+
+    const int tail = m_width % 64;
+    const quint64 lastMask = tail ? (quint64(1) << tail) - 1 : ~quint64(0);
+
+    for (int r = 0; r < m_height; ++r) {
+        for (int w = 0; w < m_rowWords; ++w) m_free[rowBegin(r) + w] = w == m_rowWords - 1 ? lastMask : ~quint64(0);
+    }
+}
+
+int OccupancyGrid::width() const { return m_width; }
+
+int OccupancyGrid::height() const { return m_height; }
+
+size_t OccupancyGrid::rowBegin(int r) const { return static_cast<size_t>(r + 1) * m_rowWords; }
+
+size_t OccupancyGrid::index(int x, int y) const { return rowBegin(y) + x / 64; }
+
+void OccupancyGrid::set(int x, int y) {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return;
+
+    const quint64 bit = quint64(1) << (x % 64);
+
+    m_blocked[index(x, y)] |= bit;
+    m_free[index(x, y)] &= ~bit;
+}
+
+bool OccupancyGrid::blocked(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return true;
+
+    return (m_blocked[index(x, y)] >> (x % 64)) & 1u;
+}
+
+void OccupancyGrid::seed(Bits& bits, int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return;
+
+    bits[index(x, y)] |= quint64(1) << (x % 64);
+}
+
+// one 4-neighbour step of `in` over [begin, end), restricted to free cells; the guard rows
+// above and below the band must be empty
+void OccupancyGrid::dilate(const Bits& in, Bits& out, size_t begin, size_t end) const {
+    const size_t s = static_cast<size_t>(m_rowWords);
+    const quint64* src = in.data();
+    const quint64* freeBits = m_free.data();
+    quint64* dst = out.data();
+
+    for (size_t row = begin; row < end; row += s) {
+        for (size_t i = row; i < row + s; ++i) {
+            const quint64 v = src[i];
+            const quint64 left = i > row ? src[i - 1] >> 63 : 0;
+            const quint64 right = i + 1 < row + s ? src[i + 1] << 63 : 0;
+
+            dst[i] = (v | (v << 1) | (v >> 1) | left | right | src[i - s] | src[i + s]) & freeBits[i];
+        }
+    }
+}
+
+int OccupancyGrid::reachable(int x, int y, int maxSteps) const {
+    if (y < 0 || y >= m_height) return 0;
+
+    const int r0 = std::max(0, y - maxSteps), r1 = std::min(m_height - 1, y + maxSteps);
+    const size_t begin = rowBegin(r0), end = rowBegin(r1 + 1);
+
+    // the rows just outside the band are read by dilate and must be empty
+    std::fill(m_a.begin() + (begin - m_rowWords), m_a.begin() + (end + m_rowWords), 0);
+    seed(m_a, x, y);
+
+    for (int step = 0; step < maxSteps; ++step) {
+        bool grew = false;
+
+        dilate(m_a, m_b, begin, end);
+
+        for (size_t i = begin; i < end; ++i) {
+            const quint64 next = m_b[i] | m_a[i];
+
+            grew |= next != m_a[i];
+            m_a[i] = next;
+        }
+
+        if (!grew) break;
+    }
+
+    int total = 0;
+
+    for (size_t i = begin; i < end; ++i) total += std::popcount(m_a[i]);
+
+    return total;
+}
+
+int OccupancyGrid::voronoi(int x, int y, const std::vector<std::pair<int, int>>& rivals, int maxSteps) const {
+    if (y < 0 || y >= m_height) return 0;
+
+    const int r0 = std::max(0, y - maxSteps), r1 = std::min(m_height - 1, y + maxSteps);
+    const size_t begin = rowBegin(r0), end = rowBegin(r1 + 1);
+    Bits& mine = m_a;
+    Bits& theirs = m_b;
+    Bits& grownMine = m_c;
+    Bits& grownTheirs = m_d;
+
+    std::fill(mine.begin() + (begin - m_rowWords), mine.begin() + (end + m_rowWords), 0);
+    std::fill(theirs.begin() + (begin - m_rowWords), theirs.begin() + (end + m_rowWords), 0);
+    seed(mine, x, y);
+
+    for (const auto& r : rivals) seed(theirs, r.first, std::clamp(r.second, r0, r1));
+
+    // claimed = every cell already owned by someone or contested; frontiers only grow into the rest
+    for (size_t i = begin; i < end; ++i) m_claimed[i] = mine[i] | theirs[i];
+
+    int owned = 0;
+
+    for (int step = 0; step < maxSteps; ++step) {
+        quint64 grew = 0, mineLeft = 0;
+
+        dilate(mine, grownMine, begin, end);
+        dilate(theirs, grownTheirs, begin, end);
+
+        for (size_t i = begin; i < end; ++i) {
+            const quint64 a = grownMine[i] & ~m_claimed[i], b = grownTheirs[i] & ~m_claimed[i], tie = a & b;
+
+            mine[i] = a & ~tie;
+            theirs[i] = b & ~tie;
+            m_claimed[i] |= a | b;
+            owned += std::popcount(mine[i]);
+            grew |= a | b;
+            mineLeft |= mine[i];
+        }
+
+        // once our frontier is gone the rivals can't change our count any more
+        if (!grew || !mineLeft) break;
+    }
+
+    return owned;
+}
@@ -0,0 +1,53 @@
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+// Packed occupancy bitboard of the arena: one bit per cell, 64 cells per word,
+// rows padded to whole words. Flood fills run word-parallel: one dilation step
+// shifts every row left and right (carrying across word boundaries) and ORs in
+// the rows above and below, so a 150x150 arena expands in ~450 word operations.
+// The grid has an empty guard row above and below so dilation never bounds-checks
+// the vertical neighbours.
+// A search from (x, y) limited to maxSteps only touches the rows it can reach;
+// rivals outside that band race from the nearest band row instead, which can
+// only make them arrive earlier.
+
+#include <QtGlobal>
+#include <vector>
+#include <utility>
+
+class OccupancyGrid {
+public:
+    void resize(int width, int height);
+    void clear();
+    int width() const;
+    int height() const;
+    void set(int x, int y);
+    // outside the grid counts as blocked
+    bool blocked(int x, int y) const;
+    // cells reachable from (x, y) within maxSteps 4-neighbour moves
+    int reachable(int x, int y, int maxSteps) const;
+    // multi-source race: cells (x, y) reaches strictly before any rival; ties go to nobody
+    int voronoi(int x, int y, const std::vector<std::pair<int, int>>& rivals, int maxSteps) const;
+private:
+    using Bits = std::vector<quint64>;
+
+    size_t index(int x, int y) const;
+    void seed(Bits& bits, int x, int y) const;
+    // first word of row r; row -1 and row height are the guard rows
+    size_t rowBegin(int r) const;
+    void dilate(const Bits& in, Bits& out, size_t begin, size_t end) const;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_rowWords = 0;
+    Bits m_blocked;
+    // free cells with the row padding already cleared
+    Bits m_free;
+    mutable Bits m_a;
+    mutable Bits m_b;
+    mutable Bits m_c;
+    mutable Bits m_d;
+    mutable Bits m_claimed;
+};
+
+#endif // OCCUPANCYGRID_H
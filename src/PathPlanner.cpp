@@ -0,0 +1,485 @@
+#include "PathPlanner.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// octile step costs in integers, so scores are identical on every platform
+const int straightCost = 10;
+const int diagonalCost = 14;
+// a route is checked for new trails this many cells ahead of the asking bot
+const int checkAhead = 16;
+// bots steer at the route point this many cells ahead of the nearest one
+const int carrotCells = 6;
+// routes nobody asked for in this many ticks are dropped
+const quint32 idleTicks = 120;
+// smallest danger distance over a region that counts as open for openRegion()
+const int openDistance = 3;
+// waypoints each route slot starts with room for; hardly any route has more turns
+const size_t routeReserve = 64;
+// cells a straight jump tries to cross at once through empty space, then a quarter of it
+const int skipRun = 16;
+
+int sign(int v) { return (v > 0) - (v < 0); }
+
+int chebyshev(const PathPlanner::Cell& a, const PathPlanner::Cell& b) { return std::max(std::abs(a.first - b.first), std::abs(a.second - b.second)); }
+
+int octile(const PathPlanner::Cell& a, const PathPlanner::Cell& b) {
+    const int dx = std::abs(a.first - b.first), dy = std::abs(a.second - b.second);
+
+    return straightCost * std::max(dx, dy) + (diagonalCost - straightCost) * std::min(dx, dy);
+}
+
+PathPlanner::Cell regionOf(const PathPlanner::Cell& c) { return {c.first / PathPlanner::regionSize, c.second / PathPlanner::regionSize}; }
+
+}
+
+// min-heap on f; the node index breaks ties so the expansion order never depends on the heap
+bool PathPlanner::later(const OpenNode& a, const OpenNode& b) { return a.f != b.f ? a.f > b.f : a.node > b.node; }
+
+void PathPlanner::reset(int width, int height) {
+    m_width = std::max(1, width);
+    m_height = std::max(1, height);
+    for (Route& r : m_routes) r.live = false;
+
+    m_pending.clear();
+    m_pending.reserve(maxPending);
+    m_routes.reserve(maxRoutes);
+    m_open.clear();
+    m_searching = false;
+    m_expanded = 0;
+
+    const size_t cells = static_cast<size_t>(m_width) * m_height;
+
+    if (m_seen.size() != cells) {
+        m_seen.assign(cells, 0);
+        m_closed.assign(cells, 0);
+        m_g.resize(cells);
+        m_parent.resize(cells);
+        m_stamp = 0;
+    }
+
+    m_regionsX = (m_width + regionSize - 1) / regionSize;
+    m_regionsY = (m_height + regionSize - 1) / regionSize;
+}
+
+int PathPlanner::routesCached() const { return static_cast<int>(std::count_if(m_routes.begin(), m_routes.end(), [](const Route& r) { return r.live; })); }
+
+int PathPlanner::searchesQueued() const { return static_cast<int>(m_pending.size()); }
+
+qint64 PathPlanner::nodesExpanded() const { return m_expanded; }
+
+// trail cells are walls; cells right next to one only count as open near the start and goal, where
+// the asking bot's own fresh trail and the target's sit
+bool PathPlanner::walkable(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return false;
+
+    const int d = m_field->distance(x, y);
+
+    if (d > 1) return true;
+
+    const Cell c(x, y);
+    const Search& s = m_pending.front();
+
+    if (c == s.goal) return true;
+
+    return d > 0 && (chebyshev(c, s.start) <= 2 || chebyshev(c, s.goal) <= 2);
+}
+
+void PathPlanner::enqueue(const Cell& start, const Cell& goal) {
+    for (const Search& s : m_pending) {
+        if (regionOf(s.goal) == regionOf(goal) && regionOf(s.start) == regionOf(start)) return;
+    }
+
+    if (static_cast<int>(m_pending.size()) >= maxPending) return;
+
+    m_pending.push_back({start, goal});
+}
+
+void PathPlanner::beginSearch() {
+    if (++m_stamp == 0) {
+        std::fill(m_seen.begin(), m_seen.end(), 0);
+        std::fill(m_closed.begin(), m_closed.end(), 0);
+        m_stamp = 1;
+    }
+
+    const Search& s = m_pending.front();
+
+    m_searching = true;
+    m_open.clear();
+    m_goalNode = s.goal.second * m_width + s.goal.first;
+
+    const int start = s.start.second * m_width + s.start.first;
+
+    m_seen[start] = m_stamp;
+    m_g[start] = 0;
+    m_parent[start] = -1;
+    m_open.push_back({octile(s.start, s.goal), start});
+}
+
+void PathPlanner::pushNode(const Cell& c, int parent) {
+    const int node = c.second * m_width + c.first;
+    const Cell from(parent % m_width, parent / m_width);
+    const int g = m_g[parent] + octile(from, c);
+
+    if (m_closed[node] == m_stamp) return;
+
+    if (m_seen[node] == m_stamp && m_g[node] <= g) return;
+
+    m_seen[node] = m_stamp;
+    m_g[node] = g;
+    m_parent[node] = parent;
+    m_open.push_back({g + octile(c, m_pending.front().goal), node});
+    std::push_heap(m_open.begin(), m_open.end(), later);
+}
+
+// every cell a jump steps onto counts against the node budget
+bool PathPlanner::jumpStraight(int x, int y, int dx, int dy, Cell& out) {
+    const Cell goal = m_pending.front().goal;
+
+    while (true) {
+        const int skip = skipStraight(x, y, dx, dy);
+
+        if (skip > 0) {
+            x += dx * skip;
+            y += dy * skip;
+            ++m_steps;
+
+            continue;
+        }
+
+        x += dx;
+        y += dy;
+        ++m_steps;
+
+        if (!walkable(x, y)) return false;
+
+        if (Cell(x, y) == goal) break;
+
+        if (dx != 0) {
+            if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) || (walkable(x, y + 1) && !walkable(x - dx, y + 1))) break;
+        } else if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) || (walkable(x + 1, y) && !walkable(x + 1, y - dy))) {
+            break;
+        }
+    }
+
+    out = {x, y};
+
+    return true;
+}
+
+// a run can't hold a jump point, nor a cell that isn't walkable, while no trail lies within two cells
+// of it; so when the pyramid says that band is empty the jump crosses it in one step
+int PathPlanner::skipStraight(int x, int y, int dx, int dy) const {
+    const Cell goal = m_pending.front().goal;
+
+    for (int run : {skipRun, skipRun / 4}) {
+        // the band of cells whose walkability the run's jump point tests can see
+        const int ax = dx ? x - dx : x - 2, ay = dy ? y - dy : y - 2;
+        const int bx = dx ? x + dx * (run + 1) : x + 2, by = dy ? y + dy * (run + 1) : y + 2;
+        const int x0 = std::min(ax, bx), x1 = std::max(ax, bx), y0 = std::min(ay, by), y1 = std::max(ay, by);
+
+        // edge cells sit at distance 1, so the band keeps off them too
+        if (x0 < 1 || y0 < 1 || x1 > m_width - 2 || y1 > m_height - 2) continue;
+
+        if (goal.first >= x0 && goal.first <= x1 && goal.second >= y0 && goal.second <= y1) continue;
+
+        if (m_field->empty(x0, y0, x1, y1)) return run;
+    }
+
+    return 0;
+}
+
+// a diagonal step needs both orthogonal cells open; it stops where a straight jump finds something
+bool PathPlanner::jumpDiagonal(int x, int y, int dx, int dy, Cell& out) {
+    const Cell goal = m_pending.front().goal;
+    Cell ignored;
+
+    while (true) {
+        if (!walkable(x + dx, y) || !walkable(x, y + dy)) return false;
+
+        x += dx;
+        y += dy;
+        ++m_steps;
+
+        if (!walkable(x, y)) return false;
+
+        if (Cell(x, y) == goal || jumpStraight(x, y, dx, 0, ignored) || jumpStraight(x, y, 0, dy, ignored)) break;
+    }
+
+    out = {x, y};
+
+    return true;
+}
+
+// pruned neighbours: the way the node was entered, plus the turns its walls force
+void PathPlanner::expand(int node) {
+    const int x = node % m_width, y = node / m_width, parent = m_parent[node];
+    int dirs[8][2];
+    int count = 0;
+
+    auto add = [&](int dx, int dy) {
+        dirs[count][0] = dx;
+        dirs[count][1] = dy;
+        ++count;
+    };
+
+    if (parent < 0) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if ((dx || dy) && walkable(x + dx, y + dy) && (!dx || !dy || (walkable(x + dx, y) && walkable(x, y + dy)))) add(dx, dy);
+            }
+        }
+    } else {
+        const int dx = sign(x - parent % m_width), dy = sign(y - parent / m_width);
+
+        if (dx && dy) {
+            const bool alongY = walkable(x, y + dy), alongX = walkable(x + dx, y);
+
+            if (alongY) add(0, dy);
+
+            if (alongX) add(dx, 0);
+
+            if (alongY && alongX) add(dx, dy);
+        } else if (dx) {
+            const bool next = walkable(x + dx, y), up = walkable(x, y + 1), down = walkable(x, y - 1);
+
+            if (next) {
+                add(dx, 0);
+
+                if (up) add(dx, 1);
+
+                if (down) add(dx, -1);
+            }
+
+            if (up) add(0, 1);
+
+            if (down) add(0, -1);
+        } else {
+            const bool next = walkable(x, y + dy), right = walkable(x + 1, y), left = walkable(x - 1, y);
+
+            if (next) {
+                add(0, dy);
+
+                if (right) add(1, dy);
+
+                if (left) add(-1, dy);
+            }
+
+            if (right) add(1, 0);
+
+            if (left) add(-1, 0);
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        Cell jump;
+        const bool found = dirs[i][0] && dirs[i][1] ? jumpDiagonal(x, y, dirs[i][0], dirs[i][1], jump) : jumpStraight(x, y, dirs[i][0], dirs[i][1], jump);
+
+        if (found) pushNode(jump, node);
+    }
+}
+
+// routes sit in fixed slots whose waypoint storage is reused, so planning stops allocating once
+// every slot has held a long route
+void PathPlanner::finishSearch(bool found, quint32 tick) {
+    const Search s = m_pending.front();
+    const Cell goalRegion = regionOf(s.goal), startRegion = regionOf(s.start);
+    Route* slot = nullptr;
+
+    m_searching = false;
+    m_pending.erase(m_pending.begin());
+
+    // the route it refreshes, a free slot, a new one while there is room, or the least recently used
+    for (Route& r : m_routes) {
+        if (r.live && r.goalRegion == goalRegion && r.startRegion == startRegion) slot = &r;
+    }
+
+    for (size_t i = 0; i < m_routes.size() && !slot; ++i) {
+        if (!m_routes[i].live) slot = &m_routes[i];
+    }
+
+    if (!slot && static_cast<int>(m_routes.size()) < maxRoutes) {
+        slot = &m_routes.emplace_back();
+        slot->waypoints.reserve(routeReserve);
+    }
+
+    if (!slot) slot = &*std::min_element(m_routes.begin(), m_routes.end(), [](const Route& a, const Route& b) { return a.used < b.used; });
+
+    slot->goalRegion = goalRegion;
+    slot->startRegion = startRegion;
+    slot->born = slot->used = tick;
+    slot->unreachable = !found;
+    slot->live = true;
+    slot->waypoints.clear();
+
+    if (found) {
+        for (int node = m_goalNode; node >= 0; node = m_parent[node]) slot->waypoints.push_back({node % m_width, node / m_width});
+
+        std::reverse(slot->waypoints.begin(), slot->waypoints.end());
+    }
+}
+
+void PathPlanner::update(const DangerField& field, quint32 tick, int nodes) {
+    if (field.width() != m_width || field.height() != m_height) return;
+
+    m_field = &field;
+
+    for (Route& r : m_routes) {
+        if (tick - r.used > idleTicks) r.live = false;
+    }
+
+    qint64 budget = nodes;
+
+    while (budget > 0 && !m_pending.empty()) {
+        if (!m_searching) beginSearch();
+
+        if (m_open.empty()) {
+            finishSearch(false, tick);
+            continue;
+        }
+
+        std::pop_heap(m_open.begin(), m_open.end(), later);
+        const int node = m_open.back().node;
+        m_open.pop_back();
+
+        if (m_closed[node] == m_stamp) continue;
+
+        m_closed[node] = m_stamp;
+
+        if (node == m_goalNode) {
+            finishSearch(true, tick);
+            continue;
+        }
+
+        const qint64 before = m_steps;
+
+        expand(node);
+        budget -= 1 + (m_steps - before);
+        ++m_expanded;
+    }
+}
+
+// routes are chains of straight and diagonal runs, so a point on one is a waypoint plus whole steps
+int PathPlanner::nearestSegment(const Route& r, const Cell& from, int& step, int& dist) const {
+    int best = -1;
+
+    dist = 1 << 30;
+
+    for (size_t i = 0; i + 1 < r.waypoints.size(); ++i) {
+        const Cell a = r.waypoints[i], b = r.waypoints[i + 1];
+        const int dx = sign(b.first - a.first), dy = sign(b.second - a.second), length = chebyshev(a, b);
+        const int along = (from.first - a.first) * dx + (from.second - a.second) * dy;
+        const int t = std::clamp(dx && dy ? along / 2 : along, 0, length);
+        const int d = chebyshev(from, Cell(a.first + dx * t, a.second + dy * t));
+
+        if (d < dist) {
+            dist = d;
+            step = t;
+            best = static_cast<int>(i);
+        }
+    }
+
+    return best;
+}
+
+bool PathPlanner::route(const DangerField& field, const Cell& start, const Cell& goal, quint32 tick, Cell& waypoint) {
+    if (field.width() != m_width || field.height() != m_height) return false;
+
+    m_field = &field;
+
+    const Cell from(std::clamp(start.first, 0, m_width - 1), std::clamp(start.second, 0, m_height - 1));
+    const Cell to(std::clamp(goal.first, 0, m_width - 1), std::clamp(goal.second, 0, m_height - 1));
+    const Cell goalRegion = regionOf(to), startRegion = regionOf(from);
+    bool knownUnreachable = false;
+    Route* best = nullptr;
+    Cell bestCarrot;
+
+    for (Route& r : m_routes) {
+        if (!r.live || r.goalRegion != goalRegion) continue;
+
+        if (r.unreachable) {
+            knownUnreachable = knownUnreachable || (r.startRegion == startRegion && tick - r.born < refreshTicks);
+            continue;
+        }
+
+        int step = 0, dist = 0;
+        int seg = nearestSegment(r, from, step, dist);
+
+        if (seg < 0 || dist > regionSize || (best && best->born >= r.born)) continue;
+
+        // walk the route ahead of us: it has to be free of new trails, and the carrot sits on it
+        const Cell end = r.waypoints.back();
+        Cell carrot = end;
+        bool clear = true;
+
+        for (int walked = 0; walked < checkAhead && seg + 1 < static_cast<int>(r.waypoints.size()); ++walked) {
+            const Cell a = r.waypoints[seg], b = r.waypoints[seg + 1];
+            const Cell c(a.first + sign(b.first - a.first) * step, a.second + sign(b.second - a.second) * step);
+
+            if (walked == carrotCells) carrot = c;
+
+            if (chebyshev(c, from) > 1 && chebyshev(c, end) > 1 && m_field->distance(c.first, c.second) == 0) {
+                clear = false;
+                break;
+            }
+
+            if (++step >= chebyshev(a, b)) {
+                ++seg;
+                step = 0;
+            }
+        }
+
+        if (!clear) continue;
+
+        best = &r;
+        bestCarrot = carrot;
+    }
+
+    if (!best) {
+        if (!knownUnreachable) enqueue(from, to);
+
+        return false;
+    }
+
+    best->used = tick;
+
+    if (tick - best->born >= refreshTicks) enqueue(from, to);
+
+    waypoint = bestCarrot;
+
+    return true;
+}
+
+// rings of regions outward from ours; the first open one wins, scanned in a fixed order. Each test is
+// one pyramid query, so nothing is rebuilt per tick
+bool PathPlanner::openRegion(const DangerField& field, const Cell& from, int minRegions, Cell& out) const {
+    if (field.width() != m_width || field.height() != m_height) return false;
+
+    const Cell r = regionOf(from);
+    const int maxRing = std::max(m_regionsX, m_regionsY);
+
+    for (int ring = std::max(1, minRegions); ring < maxRing; ++ring) {
+        for (int ry = r.second - ring; ry <= r.second + ring; ++ry) {
+            for (int rx = r.first - ring; rx <= r.first + ring; ++rx) {
+                if (std::max(std::abs(rx - r.first), std::abs(ry - r.second)) != ring) continue;
+
+                if (rx < 0 || ry < 0 || rx >= m_regionsX || ry >= m_regionsY) continue;
+
+                // open: every cell at least openDistance from the edge and from any trail cell
+                const int x0 = rx * regionSize, y0 = ry * regionSize;
+                const int x1 = std::min(m_width, x0 + regionSize) - 1, y1 = std::min(m_height, y0 + regionSize) - 1;
+
+                if (x0 < openDistance - 1 || y0 < openDistance - 1 || x1 > m_width - openDistance || y1 > m_height - openDistance) continue;
+
+                if (!field.empty(x0 - openDistance + 1, y0 - openDistance + 1, x1 + openDistance - 1, y1 + openDistance - 1)) continue;
+
+                out = {std::min(m_width - 1, rx * regionSize + regionSize / 2), std::min(m_height - 1, ry * regionSize + regionSize / 2)};
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
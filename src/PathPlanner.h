@@ -0,0 +1,97 @@
+#ifndef PATHPLANNER_H
+#define PATHPLANNER_H
+
+// Long-range routes for the bots over the DangerField cells. Searches are jump
+// point search on the 8-connected grid (no corner cutting, so diagonal trails
+// stay watertight) and run in the background: route() answers from a cache
+// and queues a search on a miss, update() expands at most a fixed number of
+// nodes per tick, carrying an unfinished search over to the next tick.
+// Routes are cached per goal region (regionSize x regionSize cells) and shared
+// by every bot close to one of them, so a pack hunting the same target plans
+// once. A route is checked ahead of the asking bot on every lookup and dropped
+// when a new trail cuts it; routes older than refreshTicks are replanned in
+// the background (expired trails may have opened a shorter way) while the old
+// one is still handed out. Everything counts nodes and ticks, never the clock,
+// so lockstep peers plan identically.
+
+#include <QtGlobal>
+#include <utility>
+#include <vector>
+#include "DangerField.h"
+
+class PathPlanner {
+public:
+    using Cell = std::pair<int, int>;
+
+    static constexpr int regionSize = 4;
+    static constexpr int maxRoutes = 32;
+    static constexpr int maxPending = 8;
+    static constexpr int refreshTicks = 30;
+
+    // forgets every route and search; the grid matches a danger field of this size
+    void reset(int width, int height);
+    // expands up to `nodes` jump points over the queued searches, oldest first
+    void update(const DangerField& field, quint32 tick, int nodes);
+    // next waypoint from `from` towards `to`; false while no route is known yet or none exists
+    bool route(const DangerField& field, const Cell& from, const Cell& to, quint32 tick, Cell& waypoint);
+    // centre of the nearest region at least `minRegions` away whose cells are all open; false if none
+    bool openRegion(const DangerField& field, const Cell& from, int minRegions, Cell& out) const;
+
+    int routesCached() const;
+    int searchesQueued() const;
+    qint64 nodesExpanded() const;
+private:
+    struct Route {
+        Cell goalRegion;
+        Cell startRegion;
+        std::vector<Cell> waypoints;
+        quint32 born = 0;
+        quint32 used = 0;
+        bool unreachable = false;
+        bool live = false;
+    };
+
+    struct Search {
+        Cell start;
+        Cell goal;
+    };
+
+    struct OpenNode {
+        int f;
+        int node;
+    };
+
+    bool walkable(int x, int y) const;
+    int nearestSegment(const Route& r, const Cell& from, int& step, int& dist) const;
+    void enqueue(const Cell& start, const Cell& goal);
+    void beginSearch();
+    void expand(int node);
+    int skipStraight(int x, int y, int dx, int dy) const;
+    bool jumpStraight(int x, int y, int dx, int dy, Cell& out);
+    bool jumpDiagonal(int x, int y, int dx, int dy, Cell& out);
+    static bool later(const OpenNode& a, const OpenNode& b);
+    void pushNode(const Cell& c, int parent);
+    void finishSearch(bool found, quint32 tick);
+
+    // the field of the current call; the owner's field may move, so it isn't kept between calls
+    const DangerField* m_field = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<Route> m_routes;
+    std::vector<Search> m_pending;
+    // the search in progress (front of m_pending): scores and parents stamped per search, so nothing is cleared
+    bool m_searching = false;
+    int m_goalNode = -1;
+    quint32 m_stamp = 0;
+    std::vector<quint32> m_seen;
+    std::vector<quint32> m_closed;
+    std::vector<int> m_g;
+    std::vector<int> m_parent;
+    std::vector<OpenNode> m_open;
+    int m_regionsX = 0;
+    int m_regionsY = 0;
+    qint64 m_expanded = 0;
+    qint64 m_steps = 0;
+};
+
+#endif // PATHPLANNER_H
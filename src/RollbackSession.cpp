@@ -0,0 +1,234 @@
+#include "RollbackSession.h"
+#include <QNetworkDatagram>
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const quint16 rollbackMagic = 0x4C52; // "LR"
+const quint8 rollbackVersion = 1;
+
+}
+
+void GridState::reset() {
+    score[0] = score[1] = 0;
+    startRound();
+}
+
+void GridState::startRound() {
+    trail[0].fill(0);
+    trail[1].fill(0);
+    x[0] = 20;
+    x[1] = width - 20;
+    y[0] = y[1] = height / 2;
+    dx[0] = 1;
+    dx[1] = -1;
+    dy[0] = dy[1] = 0;
+    alive[0] = alive[1] = true;
+    active = true;
+    idleFrames = 0;
+}
+
+bool GridState::occupied(int player, int cx, int cy) const {
+    const int bit = cy * width + cx;
+
+    return (trail[player][bit >> 6] >> (bit & 63)) & 1u;
+}
+
+void GridState::step(const quint8 input[2]) {
+    if (!active) return;
+
+    for (int p = 0; p < 2; ++p) {
+        switch (input[p]) {
+        case Up: dx[p] = 0; dy[p] = -1; break;
+        case Down: dx[p] = 0; dy[p] = 1; break;
+        case Left: dx[p] = -1; dy[p] = 0; break;
+        case Right: dx[p] = 1; dy[p] = 0; break;
+        default: break;
+        }
+    }
+
+    // both bikes move before either is checked, as in the original QSet version
+    for (int p = 0; p < 2; ++p) {
+        if (!alive[p]) continue;
+
+        const int bit = y[p] * width + x[p];
+
+        trail[p][bit >> 6] |= quint64(1) << (bit & 63);
+        x[p] += dx[p];
+        y[p] += dy[p];
+    }
+
+    for (int p = 0; p < 2; ++p) {
+        if (!alive[p]) continue;
+
+        if (x[p] < 0 || x[p] >= width || y[p] < 0 || y[p] >= height) alive[p] = false;
+        else if (occupied(0, x[p], y[p]) || occupied(1, x[p], y[p])) alive[p] = false;
+    }
+
+    if (!alive[0] || !alive[1]) {
+        active = false;
+        idleFrames = 0;
+
+        if (alive[0]) ++score[0];
+
+        if (alive[1]) ++score[1];
+    }
+}
+
+RollbackSession::RollbackSession(const Config& config, QObject* parent) : QObject(parent), m_config(config) {
+    m_config.localPlayer = std::clamp(m_config.localPlayer, 0, 1);
+    m_config.inputDelay = std::clamp(m_config.inputDelay, 0, maxPrediction);
+    m_socket = new QUdpSocket(this);
+    m_localFrames.fill(-1);
+    m_state.reset();
+    connect(m_socket, &QUdpSocket::readyRead, this, &RollbackSession::onReadyRead);
+}
+
+bool RollbackSession::start() {
+    if (!m_socket->bind(QHostAddress::AnyIPv4, m_config.localPort)) {
+        qWarning() << "RollbackSession: cannot bind UDP port" << m_config.localPort << m_socket->errorString();
+
+        return false;
+    }
+
+    sendInputs();
+
+    return true;
+}
+
+const GridState& RollbackSession::state() const { return m_state; }
+
+int RollbackSession::frame() const { return m_frame; }
+
+int RollbackSession::localPlayer() const { return m_config.localPlayer; }
+
+bool RollbackSession::isSynchronized() const { return m_synced; }
+
+int RollbackSession::lastRollbackFrames() const { return m_lastRollback; }
+
+quint8 RollbackSession::localInputAt(int frame) const {
+    const int i = frame % inputRing;
+
+    return m_localFrames[i] == frame ? m_localInputs[i] : GridState::None;
+}
+
+// unconfirmed frames are predicted as "no turn", which is right for all but the frames a key was pressed
+quint8 RollbackSession::remoteInputAt(int frame) const {
+    return frame <= m_confirmedRemote ? m_remoteInputs[frame % inputRing] : GridState::None;
+}
+
+void RollbackSession::simulate(int frame, quint8 remote) {
+    if (!m_state.active) {
+        if (++m_state.idleFrames >= restartFrames) m_state.startRound();
+
+        return;
+    }
+
+    quint8 input[2];
+    input[m_config.localPlayer] = localInputAt(frame);
+    input[1 - m_config.localPlayer] = remote;
+    m_state.step(input);
+}
+
+void RollbackSession::rollback() {
+    const int from = m_firstMispredicted;
+
+    m_firstMispredicted = -1;
+    m_state = m_saved[from % ringSize].state;
+
+    for (int f = from; f < m_frame; ++f) {
+        Saved& s = m_saved[f % ringSize];
+
+        s.state = m_state;
+        s.remoteUsed = remoteInputAt(f);
+        simulate(f, s.remoteUsed);
+    }
+
+    m_lastRollback = m_frame - from;
+}
+
+bool RollbackSession::advance(quint8 localInput) {
+    if (!m_synced) {
+        sendInputs();
+
+        return false;
+    }
+
+    if (m_firstMispredicted >= 0) rollback();
+
+    // never run further ahead of the peer than the snapshot ring can rewind
+    if (m_frame > m_confirmedRemote + maxPrediction) {
+        sendInputs();
+
+        return false;
+    }
+
+    const int inputFrame = m_frame + m_config.inputDelay;
+    const int i = inputFrame % inputRing;
+
+    m_localInputs[i] = localInput;
+    m_localFrames[i] = inputFrame;
+    m_lastLocalFrame = inputFrame;
+
+    Saved& s = m_saved[m_frame % ringSize];
+
+    s.frame = m_frame;
+    s.state = m_state;
+    s.remoteUsed = remoteInputAt(m_frame);
+    simulate(m_frame, s.remoteUsed);
+    ++m_frame;
+    sendInputs();
+
+    return true;
+}
+
+// every packet repeats all local inputs the peer has not acked yet, so a lost datagram costs nothing
+void RollbackSession::sendInputs() {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    const int first = std::max({m_peerAck + 1, m_lastLocalFrame - maxInputsPerPacket + 1, 0});
+    const int count = std::max(0, m_lastLocalFrame - first + 1);
+
+    out << rollbackMagic << rollbackVersion << qint32(m_confirmedRemote) << qint32(first) << quint8(count);
+
+    for (int f = first; f < first + count; ++f) out << localInputAt(f);
+
+    m_socket->writeDatagram(data, m_config.remoteHost, m_config.remotePort);
+}
+
+void RollbackSession::onReadyRead() {
+    while (m_socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_socket->receiveDatagram();
+        QByteArray data = datagram.data();
+        QDataStream in(data);
+        quint16 magic;
+        quint8 version, count;
+        qint32 ack, first;
+
+        in >> magic >> version >> ack >> first >> count;
+
+        if (in.status() != QDataStream::Ok || magic != rollbackMagic || version != rollbackVersion) continue;
+
+        m_synced = true;
+        m_peerAck = std::max(m_peerAck, static_cast<int>(ack));
+
+        for (int f = first; f < first + count; ++f) {
+            quint8 input;
+            in >> input;
+
+            if (in.status() != QDataStream::Ok) break;
+
+            // only extend the confirmed run; gaps are filled by the peer's next resend
+            if (f != m_confirmedRemote + 1) continue;
+
+            m_remoteInputs[f % inputRing] = input;
+            m_confirmedRemote = f;
+
+            if (f < m_frame && m_saved[f % ringSize].frame == f && m_saved[f % ringSize].remoteUsed != input) {
+                if (m_firstMispredicted < 0 || f < m_firstMispredicted) m_firstMispredicted = f;
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef ROLLBACKSESSION_H
+#define ROLLBACKSESSION_H
+
+// Rollback netplay for the 2-player grid mode.
+// GridState is the whole match in a few kilobytes of plain data (two trail
+// bitboards plus heads and scores), so saving or restoring it is a single copy.
+// Each peer simulates immediately with a predicted remote input ("no turn"),
+// keeps the state it started every frame from, and when the real remote input
+// for an old frame disagrees it restores that frame and re-simulates up to now.
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <array>
+#include <type_traits>
+
+struct GridState {
+    static constexpr int width = 160;
+    static constexpr int height = 120;
+    static constexpr int words = (width * height + 63) / 64;
+
+    // turn events; None keeps the current heading
+    enum Input : quint8 {
+        None = 0,
+        Up,
+        Down,
+        Left,
+        Right
+    };
+
+    std::array<quint64, words> trail[2];
+    qint16 x[2];
+    qint16 y[2];
+    qint8 dx[2];
+    qint8 dy[2];
+    bool alive[2];
+    bool active;
+    quint16 score[2];
+    // frames since the round ended; the netplay session restarts rounds on its own
+    quint16 idleFrames;
+
+    void reset();
+    void startRound();
+    void step(const quint8 input[2]);
+    bool occupied(int player, int cx, int cy) const;
+};
+
+static_assert(std::is_trivially_copyable_v<GridState>);
+
+class RollbackSession : public QObject {
+    Q_OBJECT
+public:
+    struct Config {
+        int localPlayer = 0;
+        quint16 localPort = 7788;
+        QHostAddress remoteHost = QHostAddress::LocalHost;
+        quint16 remotePort = 7789;
+        int inputDelay = 0;
+    };
+
+    explicit RollbackSession(const Config& config, QObject* parent = nullptr);
+    bool start();
+    // runs one frame with the local turn; false while waiting for the peer
+    bool advance(quint8 localInput);
+    const GridState& state() const;
+    int frame() const;
+    int localPlayer() const;
+    bool isSynchronized() const;
+    // frames re-simulated by the most recent rollback
+    int lastRollbackFrames() const;
+private slots:
+    void onReadyRead();
+private:
+    static constexpr int ringSize = 32;
+    static constexpr int inputRing = 128;
+    static constexpr int maxPrediction = 12;
+    static constexpr int restartFrames = 40;
+    static constexpr int maxInputsPerPacket = 64;
+
+    struct Saved {
+        int frame = -1;
+        GridState state;
+        quint8 remoteUsed = GridState::None;
+    };
+
+    quint8 localInputAt(int frame) const;
+    quint8 remoteInputAt(int frame) const;
+    void simulate(int frame, quint8 remote);
+    void rollback();
+    void sendInputs();
+
+    Config m_config;
+    QUdpSocket* m_socket;
+    GridState m_state;
+    std::array<Saved, ringSize> m_saved;
+    std::array<quint8, inputRing> m_localInputs{};
+    std::array<int, inputRing> m_localFrames;
+    std::array<quint8, inputRing> m_remoteInputs{};
+    int m_frame = 0;
+    int m_lastLocalFrame = -1;
+    int m_confirmedRemote = -1;
+    int m_peerAck = -1;
+    int m_firstMispredicted = -1;
+    int m_lastRollback = 0;
+    bool m_synced = false;
+};
+
+#endif // ROLLBACKSESSION_H
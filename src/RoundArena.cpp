@@ -0,0 +1,80 @@
+#include "RoundArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace {
+
+const size_t blockAlignment = alignof(std::max_align_t);
+const size_t growthStep = 4096;
+
+}
+
+RoundArena::RoundArena(size_t bytes) {
+    m_capacity = std::max(growthStep, (bytes + growthStep - 1) / growthStep * growthStep);
+    m_block = static_cast<std::byte*>(::operator new(m_capacity, std::align_val_t(blockAlignment)));
+}
+
+RoundArena::~RoundArena() {
+    releaseOverflow();
+    ::operator delete(m_block, std::align_val_t(blockAlignment));
+}
+
+size_t RoundArena::capacity() const { return m_capacity; }
+
+size_t RoundArena::used() const { return m_used; }
+
+size_t RoundArena::highWater() const { return m_highWater; }
+
+int RoundArena::overflows() const { return static_cast<int>(m_overflow.size()); }
+
+qint64 RoundArena::totalOverflows() const { return m_totalOverflows; }
+
+void RoundArena::releaseOverflow() {
+    for (const Overflow& o : m_overflow) std::pmr::new_delete_resource()->deallocate(o.p, o.bytes, o.alignment);
+
+    m_overflow.clear();
+}
+
+void RoundArena::reset(size_t atLeast) {
+    releaseOverflow();
+
+    // a quarter of headroom over the biggest round, so a slightly longer one still fits
+    const size_t wanted = std::max(atLeast, m_highWater + m_highWater / 4);
+
+    if (wanted > m_capacity) {
+        ::operator delete(m_block, std::align_val_t(blockAlignment));
+        m_capacity = (wanted + growthStep - 1) / growthStep * growthStep;
+        m_block = static_cast<std::byte*>(::operator new(m_capacity, std::align_val_t(blockAlignment)));
+    }
+
+    m_offset = 0;
+    m_used = 0;
+}
+
+void* RoundArena::do_allocate(size_t bytes, size_t alignment) {
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(m_block);
+    const std::uintptr_t start = (base + m_offset + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+    const size_t end = static_cast<size_t>(start - base) + bytes;
+
+    m_used += bytes;
+    m_highWater = std::max(m_highWater, m_used);
+
+    if (end <= m_capacity) {
+        m_offset = end;
+
+        return reinterpret_cast<void*>(start);
+    }
+
+    void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+
+    m_overflow.push_back({p, bytes, alignment});
+    ++m_totalOverflows;
+
+    return p;
+}
+
+// memory comes back all at once in reset()
+void RoundArena::do_deallocate(void*, size_t, size_t) {}
+
+bool RoundArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept { return this == &other; }
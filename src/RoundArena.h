@@ -0,0 +1,57 @@
+#ifndef ROUNDARENA_H
+#define ROUNDARENA_H
+
+// Monotonic memory resource for state a GameSimulation lays out again every
+// round. Allocations bump a pointer through one block and deallocation is a
+// no-op; reset() rewinds the block in O(1). A round that runs past the block
+// is served from the heap and counted as an overflow, and the next reset()
+// grows the block to the largest round seen so far, so after the first round
+// of a match play doesn't touch the heap at all. used(), highWater() and
+// overflows() are there to size it and to check exactly that.
+
+#include <QtGlobal>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+class RoundArena : public std::pmr::memory_resource {
+public:
+    explicit RoundArena(size_t bytes = 64 * 1024);
+    ~RoundArena() override;
+    RoundArena(const RoundArena&) = delete;
+    RoundArena& operator=(const RoundArena&) = delete;
+
+    // drops every allocation; the block grows first if the last round overflowed or needs `atLeast` bytes
+    void reset(size_t atLeast = 0);
+
+    size_t capacity() const;
+    // bytes handed out since the last reset, overflow included
+    size_t used() const;
+    // most bytes any round has used
+    size_t highWater() const;
+    // heap allocations since the last reset, and over the arena's life
+    int overflows() const;
+    qint64 totalOverflows() const;
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+private:
+    struct Overflow {
+        void* p;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    void releaseOverflow();
+
+    std::byte* m_block = nullptr;
+    size_t m_capacity = 0;
+    size_t m_offset = 0;
+    size_t m_used = 0;
+    size_t m_highWater = 0;
+    std::vector<Overflow> m_overflow;
+    qint64 m_totalOverflows = 0;
+};
+
+#endif // ROUNDARENA_H
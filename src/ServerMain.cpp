@@ -0,0 +1,191 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QDebug>
+#include <memory>
+#include "GameServer.h"
+#include "NetClient.h"
+#include "LatencyShim.h"
+#include "LockstepPeer.h"
+#include "MatchHost.h"
+
+// N lockstep peers on loopback, each steered at random; reports progress and stops at the first desync
+static int runLockstepTest(QCoreApplication& app, int peers, const GameServer::Config& config, qint64 fault_tick) {
+    std::vector<LockstepPeer*> nodes;
+
+    for (int i = 0; i < peers; ++i) {
+        LockstepPeer::Config lockstep;
+        lockstep.slot = i;
+        lockstep.players = peers;
+        lockstep.bots = config.bots;
+        lockstep.fieldSize = config.fieldSize;
+        lockstep.tickRate = config.tickRate;
+
+        auto* node = new LockstepPeer(lockstep, &app);
+
+        if (!node->bind()) return 1;
+
+        nodes.push_back(node);
+    }
+
+    for (LockstepPeer* node : nodes) {
+        for (LockstepPeer* other : nodes) {
+            if (other != node) node->addPeer(QHostAddress::LocalHost, other->port());
+        }
+
+        auto* steer = new QTimer(node);
+
+        QObject::connect(steer, &QTimer::timeout, node,
+            [node]() {
+                float r = static_cast<float>(QRandomGenerator::global()->generateDouble());
+
+                node->setTurnInput(r < 0.3f ? -1.0f : r > 0.7f ? 1.0f : 0.0f);
+            }
+        );
+        steer->start(700);
+        node->start();
+    }
+
+    if (fault_tick >= 0) nodes[0]->injectFault(static_cast<quint32>(fault_tick));
+
+    auto* report = new QTimer(&app);
+
+    QObject::connect(report, &QTimer::timeout, &app,
+        [nodes]() {
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                qInfo().nospace() << "lockstep peer " << i << ": tick " << nodes[i]->tick() << ", checksum " << Qt::hex
+                    << nodes[i]->simulation().checksum() << Qt::dec << ", sent " << nodes[i]->bytesSent() << " bytes"
+                    << (nodes[i]->isDesynced() ? ", DESYNCED" : "");
+            }
+        }
+    );
+    report->start(5000);
+
+    return app.exec();
+}
+
+// Dedicated server entry point.
+// `--test-clients N` additionally spawns N bot-steered clients on loopback,
+// which is the quickest way to exercise the protocol without the game UI;
+// --rtt/--jitter/--loss put them behind a LatencyShim to test prediction under lag.
+// `--lockstep-test N` runs N deterministic lockstep peers instead of the server.
+// `--instances N` hosts N independent matches on consecutive ports, spread over `--threads` workers.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lohoTRON_server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("lohoTRON dedicated UDP server");
+    parser.addHelpOption();
+
+    QCommandLineOption port_option("port", "UDP port to listen on.", "port", "7777");
+    QCommandLineOption clients_option("max-clients", "Number of player slots.", "count", "8");
+    QCommandLineOption bots_option("bots", "Number of AI bikes besides player slots.", "count", "8");
+    QCommandLineOption smart_option("smart-bots", "Drive bots with the territory AI.");
+    QCommandLineOption walls_option("persistent-walls", "Keep trails up for the whole round (classic mode).");
+    QCommandLineOption field_option("field", "Arena size in cells.", "cells", "150");
+    QCommandLineOption tick_option("tick", "Simulation tick rate (Hz).", "hz", "60");
+    QCommandLineOption snapshot_option("snapshot-rate", "Snapshot send rate (Hz).", "hz", "20");
+    QCommandLineOption aoi_option("aoi", "Radius around each client with full trail detail (world units).", "units", "90");
+    QCommandLineOption budget_option("bike-budget", "Bike updates per snapshot besides the client's own.", "count", "24");
+    QCommandLineOption instances_option("instances", "Independent matches hosted by this process.", "count", "1");
+    QCommandLineOption threads_option("threads", "Worker threads for --instances.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption test_clients_option("test-clients", "Spawn loopback test clients.", "count", "0");
+    QCommandLineOption rtt_option("rtt", "Artificial round trip for test clients (ms).", "ms", "0");
+    QCommandLineOption jitter_option("jitter", "Extra random delay per datagram for test clients (ms).", "ms", "0");
+    QCommandLineOption loss_option("loss", "Datagram loss for test clients (percent).", "percent", "0");
+    QCommandLineOption lockstep_option("lockstep-test", "Run loopback lockstep peers instead of the server.", "count", "0");
+    QCommandLineOption fault_option("lockstep-fault", "Make the first lockstep peer diverge at this tick.", "tick", "-1");
+
+    parser.addOptions({port_option, clients_option, bots_option, smart_option, walls_option, field_option, tick_option, snapshot_option, aoi_option, budget_option, instances_option, threads_option, test_clients_option, rtt_option, jitter_option, loss_option, lockstep_option, fault_option});
+    parser.process(app);
+
+    GameServer::Config config;
+    config.port = static_cast<quint16>(parser.value(port_option).toUInt());
+    config.maxClients = parser.value(clients_option).toInt();
+    config.bots = parser.value(bots_option).toInt();
+    config.smartBots = parser.isSet(smart_option);
+    config.persistentWalls = parser.isSet(walls_option);
+    config.fieldSize = parser.value(field_option).toInt();
+    config.tickRate = parser.value(tick_option).toInt();
+    config.snapshotRate = parser.value(snapshot_option).toInt();
+    config.aoiRadius = parser.value(aoi_option).toFloat();
+    config.bikeBudget = parser.value(budget_option).toInt();
+
+    const int lockstep_peers = parser.value(lockstep_option).toInt();
+
+    if (lockstep_peers > 0) return runLockstepTest(app, lockstep_peers, config, parser.value(fault_option).toLongLong());
+
+    const int instances = parser.value(instances_option).toInt();
+    std::unique_ptr<GameServer> server;
+    std::unique_ptr<MatchHost> host;
+    std::vector<quint16> ports;
+
+    if (instances > 1) {
+        host = std::make_unique<MatchHost>(config, instances, parser.value(threads_option).toInt());
+
+        if (!host->start()) return 1;
+
+        for (int i = 0; i < host->instanceCount(); ++i) ports.push_back(host->instancePort(i));
+    } else {
+        server = std::make_unique<GameServer>(config);
+
+        if (!server->start()) return 1;
+
+        ports.push_back(server->port());
+    }
+
+    const int test_clients = parser.value(test_clients_option).toInt();
+    std::vector<NetClient*> clients;
+    const int rtt = parser.value(rtt_option).toInt(), jitter = parser.value(jitter_option).toInt();
+    const double loss = parser.value(loss_option).toDouble();
+
+    if (test_clients > 0 && (rtt > 0 || jitter > 0 || loss > 0.0)) {
+        for (quint16& port : ports) {
+            auto* shim = new LatencyShim(QHostAddress::LocalHost, port, rtt, jitter, loss, &app);
+
+            if (!shim->start()) return 1;
+
+            port = shim->port();
+        }
+    }
+
+    for (int i = 0; i < test_clients; ++i) {
+        auto* client = new NetClient(&app);
+        auto* steer = new QTimer(client);
+
+        // wander like the offline bots: hold a random turn for a short while
+        QObject::connect(steer, &QTimer::timeout, client,
+            [client]() {
+                float r = static_cast<float>(QRandomGenerator::global()->generateDouble());
+
+                client->setTurnInput(r < 0.3f ? -1.0f : r > 0.7f ? 1.0f : 0.0f);
+            }
+        );
+        steer->start(700);
+        client->connectToServer(QHostAddress::LocalHost, ports[i % ports.size()], QString("test-%1").arg(i));
+        clients.push_back(client);
+    }
+
+    if (!clients.empty()) {
+        auto* report = new QTimer(&app);
+        auto last = std::make_shared<std::vector<qint64>>(clients.size(), 0);
+
+        QObject::connect(report, &QTimer::timeout, &app,
+            [clients, last]() {
+                for (size_t i = 0; i < clients.size(); ++i) {
+                    qint64 received = clients[i]->bytesReceived();
+
+                    qInfo().nospace() << "test client " << i << ": slot " << clients[i]->slot()
+                        << ", round " << clients[i]->round() << ", " << (received - (*last)[i]) / 5.0 / 1024.0 << " KiB/s"
+                        << ", last correction " << clients[i]->lastCorrection();
+                    (*last)[i] = received;
+                }
+            }
+        );
+        report->start(5000);
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,186 @@
+#include "SfxBank.h"
+#include "FrameTrace.h"
+#include <QCoreApplication>
+#include <QMediaDevices>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+namespace {
+
+void store(int16_t& out, float s) { out = static_cast<int16_t>(std::clamp(s, float(INT16_MIN), float(INT16_MAX))); }
+
+void store(float& out, float s) { out = std::clamp(s, -1.0f, 1.0f); }
+
+}
+
+SfxMixer::SfxMixer(QObject* parent) : QIODevice(parent) { m_voices.reserve(maxVoices); }
+
+void SfxMixer::addVoice(const QByteArray* pcm, float gain) {
+    if (!pcm || pcm->isEmpty()) return;
+
+    QMutexLocker lock(&m_mutex);
+
+    // the oldest voice gives way when every slot is busy
+    if (static_cast<int>(m_voices.size()) >= maxVoices) m_voices.erase(m_voices.begin());
+
+    m_voices.push_back({pcm, 0, gain});
+}
+
+void SfxMixer::stopAll() {
+    QMutexLocker lock(&m_mutex);
+
+    m_voices.clear();
+}
+
+void SfxMixer::setSampleFormat(QAudioFormat::SampleFormat format) { m_sampleFormat = format; }
+
+bool SfxMixer::isSequential() const { return true; }
+
+template <typename Sample>
+void SfxMixer::mix(char* data, qint64 samples) {
+    auto* out = reinterpret_cast<Sample*>(data);
+    const qint64 size = sizeof(Sample);
+
+    for (Voice& v : m_voices) {
+        const auto* in = reinterpret_cast<const Sample*>(v.pcm->constData()) + v.offset / size;
+        const qint64 n = std::min(samples, (v.pcm->size() - v.offset) / size);
+
+        for (qint64 i = 0; i < n; ++i) store(out[i], static_cast<float>(out[i]) + static_cast<float>(in[i]) * v.gain);
+
+        v.offset += n * size;
+    }
+}
+
+qint64 SfxMixer::readData(char* data, qint64 maxSize) {
+    // the audio thread: a ring start() already allocated, so tracing never allocates or locks here
+    FrameTrace::adoptSpareRing("audio");
+
+    const FrameTrace::Zone zone("sfx mix");
+
+    const qint64 sampleBytes = m_sampleFormat == QAudioFormat::Float ? 4 : 2;
+
+    // round down to a whole sample
+    maxSize -= maxSize % sampleBytes;
+
+    std::memset(data, 0, static_cast<size_t>(maxSize));
+
+    QMutexLocker lock(&m_mutex);
+
+    if (m_sampleFormat == QAudioFormat::Float) mix<float>(data, maxSize / sampleBytes);
+    else mix<int16_t>(data, maxSize / sampleBytes);
+
+    m_voices.erase(
+        std::remove_if(m_voices.begin(), m_voices.end(), [](const Voice& v) { return v.offset >= v.pcm->size(); }),
+        m_voices.end()
+    );
+
+    return maxSize;
+}
+
+qint64 SfxMixer::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+SfxBank* SfxBank::instance() {
+    static SfxBank* bank = new SfxBank(QCoreApplication::instance());
+
+    return bank;
+}
+
+SfxBank::SfxBank(QObject* parent) : QObject(parent) {
+    m_format.setSampleRate(44100);
+    m_format.setChannelCount(2);
+    m_format.setSampleFormat(QAudioFormat::Int16);
+    m_clips[Crash] = {":/sfx/crash.wav", 1000, {}, false};
+    m_clips[BikeKill] = {":/sfx/bike_kill.wav", 1000, {}, false};
+    m_clips[RoundStart] = {":/sfx/round_start.wav", 1000, {}, false};
+    m_mixer = new SfxMixer(this);
+    m_mixer->open(QIODevice::ReadOnly);
+    m_decoder = new QAudioDecoder(this);
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &SfxBank::onBufferReady);
+    connect(m_decoder, &QAudioDecoder::finished, this, &SfxBank::onDecodeFinished);
+    connect(m_decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), this, [this](QAudioDecoder::Error) { onDecodeFinished(); });
+}
+
+void SfxBank::preload() {
+    if (m_preloaded) return;
+
+    m_preloaded = true;
+
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+
+    // the device can't take 44.1 kHz 16-bit stereo: use its rate and layout, keeping a sample type the mixer handles
+    if (!device.isFormatSupported(m_format)) {
+        QAudioFormat preferred = device.preferredFormat();
+
+        if (preferred.sampleFormat() != QAudioFormat::Float) preferred.setSampleFormat(QAudioFormat::Int16);
+
+        if (!device.isFormatSupported(preferred)) preferred.setSampleFormat(QAudioFormat::Float);
+
+        m_format = preferred;
+    }
+
+    // clips are decoded straight to the output format, so mixing never converts
+    m_decoder->setAudioFormat(m_format);
+    m_mixer->setSampleFormat(m_format.sampleFormat());
+    m_sink = new QAudioSink(device, m_format, this);
+    // a short device buffer is what keeps the trigger-to-sound latency low
+    m_sink->setBufferSize(static_cast<qsizetype>(m_format.bytesForDuration(30000)));
+    m_sink->start(m_mixer);
+    m_decodingClip = -1;
+    decodeNext();
+}
+
+void SfxBank::play(Effect effect, float gain) {
+    if (effect < 0 || effect >= EffectCount || !m_clips[effect].ready) return;
+
+    m_mixer->addVoice(&m_clips[effect].pcm, gain);
+}
+
+void SfxBank::decodeNext() {
+    if (m_source) {
+        m_source->deleteLater();
+        m_source = nullptr;
+    }
+
+    if (++m_decodingClip >= EffectCount) return;
+
+    m_source = new QFile(m_clips[m_decodingClip].path, this);
+
+    if (!m_source->open(QIODevice::ReadOnly)) {
+        decodeNext();
+
+        return;
+    }
+
+    m_decoder->setSourceDevice(m_source);
+    m_decoder->start();
+}
+
+void SfxBank::onBufferReady() {
+    QAudioBuffer buffer = m_decoder->read();
+
+    if (!buffer.isValid() || m_decodingClip < 0 || m_decodingClip >= EffectCount || m_clips[m_decodingClip].ready) return;
+
+    Clip& clip = m_clips[m_decodingClip];
+    const qint64 limit = m_format.bytesForDuration(static_cast<qint64>(clip.maxMs) * 1000);
+    const qint64 room = limit - clip.pcm.size();
+
+    clip.pcm.append(buffer.constData<char>(), static_cast<qsizetype>(std::min<qint64>(room, buffer.byteCount())));
+
+    // effects are short; the cap only guards against a long file slipping in
+    if (clip.pcm.size() >= limit) onDecodeFinished();
+}
+
+void SfxBank::onDecodeFinished() {
+    if (m_decodingClip < 0 || m_decodingClip >= EffectCount) return;
+
+    // the buffer is immutable from here on, so the mixer may read it from the audio thread
+    m_clips[m_decodingClip].ready = true;
+    m_decoder->stop();
+    decodeNext();
+}
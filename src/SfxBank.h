@@ -0,0 +1,87 @@
+#ifndef SFXBANK_H
+#define SFXBANK_H
+
+// Short in-game sound effects.
+// Every effect is decoded once at startup into a PCM buffer; playing one only
+// queues a voice on an always-running mixer that feeds a single QAudioSink, so
+// there is no media pipeline startup or MP3 decode on the game thread.
+
+#include <QObject>
+#include <QIODevice>
+#include <QMutex>
+#include <QByteArray>
+#include <QAudioFormat>
+#include <QAudioSink>
+#include <QAudioDecoder>
+#include <QFile>
+#include <array>
+#include <vector>
+
+// mixes active voices with saturation; outputs silence when nothing plays
+class SfxMixer : public QIODevice {
+public:
+    explicit SfxMixer(QObject* parent = nullptr);
+    void addVoice(const QByteArray* pcm, float gain);
+    void stopAll();
+    // Int16 or Float, the format the clips were decoded to; set before the sink starts
+    void setSampleFormat(QAudioFormat::SampleFormat format);
+    bool isSequential() const override;
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+private:
+    template <typename Sample>
+    void mix(char* data, qint64 samples);
+
+    struct Voice {
+        const QByteArray* pcm;
+        qint64 offset;
+        float gain;
+    };
+
+    static constexpr int maxVoices = 16;
+
+    QMutex m_mutex;
+    std::vector<Voice> m_voices;
+    QAudioFormat::SampleFormat m_sampleFormat = QAudioFormat::Int16;
+};
+
+class SfxBank : public QObject {
+    Q_OBJECT
+public:
+    enum Effect {
+        Crash,
+        BikeKill,
+        RoundStart,
+        EffectCount
+    };
+
+    static SfxBank* instance();
+    void preload();
+    void play(Effect effect, float gain = 1.0f);
+private slots:
+    void onBufferReady();
+    void onDecodeFinished();
+private:
+    explicit SfxBank(QObject* parent = nullptr);
+    void decodeNext();
+
+    struct Clip {
+        QString path;
+        // longest stretch kept from the start of the file
+        int maxMs;
+        QByteArray pcm;
+        bool ready;
+    };
+
+    QAudioFormat m_format;
+    QAudioSink* m_sink = nullptr;
+    SfxMixer* m_mixer = nullptr;
+    QAudioDecoder* m_decoder = nullptr;
+    QFile* m_source = nullptr;
+    std::array<Clip, EffectCount> m_clips;
+    int m_decodingClip = -1;
+    bool m_preloaded = false;
+};
+
+#endif // SFXBANK_H
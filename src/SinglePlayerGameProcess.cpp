@@ -1,27 +1,24 @@
 #include "SinglePlayerGameProcess.h"
 
 SinglePlayerGameProcess::SinglePlayerGameProcess(QWidget* parent) : QOpenGLWidget(parent) {
-    gameOverWindow = new GameOverWindow(this);
     connect(this, &SinglePlayerGameProcess::matchOver, this,
         [this](bool win, int killedBots, int wonRounds) {
-            music_player->stop();
-            gameOverWindow->sfx()->play();
-            gameOverWindow->setMatchResult(win, killedBots, wonRounds);
-            gameOverWindow->show();
+            MusicService::instance()->pause();
+            gameOverDialog()->sfx()->play();
+            gameOverDialog()->setMatchResult(win, killedBots, wonRounds);
+            gameOverDialog()->show();
         }
     );
-    connect(gameOverWindow, &GameOverWindow::restartGame, this, &SinglePlayerGameProcess::resetGameSlot);
-    connect(gameOverWindow, &GameOverWindow::exitToMenu, this, &SinglePlayerGameProcess::exitToMenuInternal);
     setFocusPolicy(Qt::StrongFocus);
+#ifdef LOHOTRON_WITH_OGRE
     m_root.reset();
     m_scene_manager = nullptr;
+    m_render_window = nullptr;
+#endif
     setMouseTracking(true);
     setCursor(Qt::BlankCursor);
-    m_render_window = nullptr;
     m_fieldSize = 100;
-    m_gridSize = m_fieldSize;
-    m_cellSize = 2.0f;
-    m_mapHalfSize = 0.5f * m_cellSize * static_cast<float>(m_gridSize);
+    m_sim.setFieldSize(m_fieldSize);
     m_paused = false;
     m_camYaw = 0.0f;
     m_camPitch = -0.4f;
@@ -37,19 +34,16 @@ SinglePlayerGameProcess::SinglePlayerGameProcess(QWidget* parent) : QOpenGLWidge
     m_keyBackward = false;
     m_keyLeft = false;
     m_keyRight = false;
-    m_maxForwardSpeed = 40.0f;
     m_maxBackwardSpeed = 15.0f;
-    m_acceleration = 40.0f;
     m_brakeDecel = 60.0f;
-    m_friction = 18.0f;
-    m_turnSpeed = 2.8f;
-    m_maxLeanAngle = Ogre::Degree(38.0f).valueRadians();
+    m_maxLeanAngle = qDegreesToRadians(38.0f);
     m_leanSpeed = 7.0f;
-    m_trailTTL = 1.0f;
-    m_trailMinDist = 0.35f;
     m_trailColumnSize = 0.8f;
     m_trailColumnHeight = 3.0f;
-    m_time = 0.0f;
+    loadTrailLodSettings();
+    loadSimulationSettings();
+    m_sim.setEventStream(&m_events);
+    m_eventReader = m_events.reader();
     m_lastTimeMs = 0;
     m_roundOver = false;
     m_playerRank = 0;
@@ -60,19 +54,16 @@ SinglePlayerGameProcess::SinglePlayerGameProcess(QWidget* parent) : QOpenGLWidge
     if (m_roundsCount < 1) m_roundsCount = 3;
 
     m_currentRound = 1;
-    m_bike.pos = QVector3D(0.0f, 0.0f, 0.0f);
-    m_bike.yaw = 0.0f;
-    m_bike.speed = 0.0f;
-    m_bike.lean = 0.0f;
-    m_bike.color = QVector3D(0.0f, 0.8f, 1.0f);
-    m_bike.human = true;
-    m_bike.alive = true;
-    m_bike.prevPos = m_bike.pos;
-    m_bike.currPos = m_bike.pos;
-    m_bike.aiTurnTimer = 0.0f;
-    m_bike.aiTurnDir = 0.0f;
-    m_bikes.clear();
-    m_bikeTrails.clear();
+    // bikes are spawned by resetGame() once the widget is shown
+    m_timer.start();
+    m_lastTimeMs = m_timer.elapsed();
+    m_tickTimer = new QTimer(this);
+    connect(m_tickTimer, SIGNAL(timeout()), this, SLOT(onTick()));
+}
+
+GamePauseWindow* SinglePlayerGameProcess::pauseDialog() {
+    if (pauseWindow) return pauseWindow;
+
     pauseWindow = new GamePauseWindow(this);
     connect(pauseWindow, &GamePauseWindow::resumeGame, this, [this]() { m_paused = false; });
     connect(pauseWindow, &GamePauseWindow::cancelPause, this, [this]() { m_paused = false; });
@@ -89,158 +80,60 @@ SinglePlayerGameProcess::SinglePlayerGameProcess(QWidget* parent) : QOpenGLWidge
         }
     );
 
-    if (m_botCount < 1) m_botCount = 1;
-
-    int total = 1 + m_botCount;     
-
-    m_bikes.resize(total);
-    m_bikeTrails.resize(total);
-    m_totalBots = m_botCount;
-    m_aliveBots = m_botCount;
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    QVector3D colors[6] = {
-        QVector3D(0.243f, 0.337f, 0.133f), // olive leaf
-        QVector3D(0.141f, 0.431f, 0.725f), // bright marine
-        QVector3D(0.306f, 0.008f, 0.314f), // dark amethyst
-        QVector3D(0.918f, 0.604f, 0.698f), // pink mist
-        QVector3D(0.22f, 0.302f, 0.282f), // dark slate grey
-        QVector3D(0.8f, 0.247f, 0.047f) // red ochre
-    };
-
-    float spawnRadius = m_mapHalfSize * 0.75f;
-    Bike& player_bike = m_bikes[0];
-    float player_baseAngle = 0, jitter = (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) - 0.5f) * 0.4f;
-    float player_angle = player_baseAngle + jitter, player_radiusJitter = 0.15f * spawnRadius;
-    float r = spawnRadius - player_radiusJitter + (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX)) * player_radiusJitter, x = std::cos(player_angle) * r, z = std::sin(player_angle) * r;
-
-    player_bike.pos = QVector3D(0, 0.0f, z);
-    player_bike.yaw = static_cast<float>(M_PI) - player_angle;
-    player_bike.speed = 0.0f;
-    player_bike.lean = 0.0f;
-    player_bike.color = colors[getColor()];
-    player_bike.human = true;
-    player_bike.alive = true;
-    player_bike.prevPos = player_bike.pos;
-    player_bike.currPos = player_bike.pos;
-    player_bike.aiTurnTimer = 0.5f + static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-    player_bike.aiTurnDir = 0.0f;
-    m_bikeTrails[0].clear();
-
-    TrailPoint player_tp;
-    player_tp.pos = player_bike.pos;
-    player_tp.time = m_time;
-
-    m_bikeTrails[0].push_back(player_tp);
-
-    for (int i = 1; i < total; ++i) {
-        Bike& b = m_bikes[i];
-        float baseAngle = (static_cast<float>(i) / static_cast<float>(total)) * 2.0f * static_cast<float>(M_PI), jitter = (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) - 0.5f) * 0.4f;
-        float angle = baseAngle + jitter, radiusJitter = 0.15f * spawnRadius;
-        float r = spawnRadius - radiusJitter + (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX)) * radiusJitter, x = std::cos(angle) * r, z = std::sin(angle) * r;
-        
-        b.pos = QVector3D(x, 0.0f, z);
-        b.yaw = -angle + static_cast<float>(M_PI); 
-        b.speed = 0.0f;
-        b.lean = 0.0f;
-        b.color = colors[5];
-        b.human = false;
-        b.alive = true;
-        b.prevPos = b.pos;
-        b.currPos = b.pos;
-        b.aiTurnTimer = 0.5f + static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-        b.aiTurnDir = 0.0f;
-        m_bikeTrails[i].clear();
-        
-        TrailPoint tp;
-        tp.pos = b.pos;
-        tp.time = m_time;
-        
-        m_bikeTrails[i].push_back(tp);
-    }
-
-    if (!m_bikes.empty()) m_camTarget = m_bikes[0].pos + QVector3D(0.0f, m_camTargetHeight, 0.0f);
-
-    m_timer.start();
-    m_lastTimeMs = m_timer.elapsed();
-    m_tickTimer = new QTimer(this);
-    connect(m_tickTimer, SIGNAL(timeout()), this, SLOT(onTick()));
-    m_tickTimer->start(16);
-    music_player = new QMediaPlayer;
-    music_output = new QAudioOutput;
-    music_player->setAudioOutput(music_output);
-    music_output->setVolume(1);
-
-    QStringList music_playlist = {
-        "music/Дальнобойщики [PHONK __ ФОНК].mp3",
-        "music/Tyler The Creator - DOGTOOTH (NEVER DULL REMIX).mp3",
-        "music/Kanye_West_Praise_God.mp3",
-        "music/R3hab & Fafaq & DNF - Sorry I Missed Your Call.mp3",
-        "music/Seeing Is Believing.mp3",
-        "music/Pi'erre Bourne - Be Mine.mp3",
-        "music/1531411811_juice-wrld-lil-uzi-vert-wasted.mp3",
-        "music/gone-fludd-park-mechty-navyazchivogo-sostoyaniya.mp3",
-        "music/1551015094_a-boogie-wit-da-hoodie-feat_-6ix9i-swervin-2018-muzonov_net.mp3",
-        "music/Travis Scott - BUTTERFLY EFFECT.mp3",
-        "music/PAY ATTENTION.mp3",
-        "music/MEET AT THE SPOT.mp3",
-        "music/Moving Too Fast (feat. Young Nudy).mp3",
-        "music/Metro Boomin, Future - I Can't Save You (Interlude) [feat. Don Toliver].mp3",
-        "music/Metro Boomin, Future, Lil Uzi Vert - All The Way Live (Spider-Man_ Across the Spider-Verse).mp3"
-    };
+    return pauseWindow;
+}
 
-    srand(time(NULL));
+GameOverWindow* SinglePlayerGameProcess::gameOverDialog() {
+    if (gameOverWindow) return gameOverWindow;
 
-    unsigned short track_num = rand() % 15 + 1;
+    gameOverWindow = new GameOverWindow(this);
+    connect(gameOverWindow, &GameOverWindow::restartGame, this, &SinglePlayerGameProcess::resetGameSlot);
+    connect(gameOverWindow, &GameOverWindow::exitToMenu, this, &SinglePlayerGameProcess::exitToMenuInternal);
 
-    music_player->setSource(QUrl::fromLocalFile(music_playlist[track_num - 1]));
-    music_player->play();
-    connect(this->music_player, &QMediaPlayer::mediaStatusChanged, this,
-        [this, music_playlist, &track_num]() {
-            if (music_player->mediaStatus() == QMediaPlayer::EndOfMedia || music_player->mediaStatus() == QMediaPlayer::NoMedia) {
-                track_num = rand() % 15 + 1;
-                music_player->setSource(QUrl(music_playlist[track_num - 1]));
-                music_player->play();
-            }
-        }
-    );
+    return gameOverWindow;
 }
 
 void SinglePlayerGameProcess::setFieldSize(int n) {
     m_fieldSize = std::max(10, n);
-    m_gridSize = m_fieldSize;
-    m_mapHalfSize = 0.5f * m_cellSize * static_cast<float>(m_gridSize);
+    m_sim.setFieldSize(m_fieldSize);
 }
 
 void SinglePlayerGameProcess::setBotCount(int n) { m_botCount = std::max(1, n); }
 
+void SinglePlayerGameProcess::setBotTier(int tier) { m_sim.setBotTier(tier ? GameSimulation::TerritoryBots : GameSimulation::ClassicBots); }
+
 void SinglePlayerGameProcess::setRoundsCount(int n) {
     m_roundsCount = std::max(1, n);
     m_currentRound = 1;
 }
 
+SinglePlayerGameProcess::~SinglePlayerGameProcess() { releaseWallBuffers(); }
+
 void SinglePlayerGameProcess::initializeGL() {
     initializeOpenGLFunctions();
+    // reparenting to another window recreates the context, and our buffers die with the old one
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &SinglePlayerGameProcess::releaseWallBuffers, Qt::UniqueConnection);
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
     glClearColor(0.0f, 0.0f, 0.03f, 1.0f);
 }
 
+// match bookkeeping for a bike the simulation just eliminated
 void SinglePlayerGameProcess::killBike(int idx) {
-    if (idx < 0 || idx >= static_cast<int>(m_bikes.size())) return;
+    const auto& bikes = m_sim.bikes();
 
-    Bike& b = m_bikes[idx];
+    if (idx < 0 || idx >= static_cast<int>(bikes.size())) return;
 
-    if (!b.alive) return;
+    const GameSimulation::Bike& b = bikes[idx];
 
-    b.alive = false;
     ++m_deadCount;
+    SfxBank::instance()->play(b.human ? SfxBank::Crash : SfxBank::BikeKill);
 
     if (!b.human && m_aliveBots > 0) --m_aliveBots;
 
     if (b.human) {
-        int total = static_cast<int>(m_bikes.size());
+        int total = static_cast<int>(bikes.size());
 
         m_playerRank = total - m_deadCount + 1;
     }
@@ -249,6 +142,8 @@ void SinglePlayerGameProcess::killBike(int idx) {
 void SinglePlayerGameProcess::resizeGL(int w, int h) { glViewport(0, 0, w, h); }
 
 void SinglePlayerGameProcess::paintGL() {
+    const FrameTrace::Zone zone("paintGL");
+
     if (!m_timer.isValid()) {
         m_timer.start();
         m_lastTimeMs = m_timer.elapsed();
@@ -263,16 +158,32 @@ void SinglePlayerGameProcess::paintGL() {
 
     if (dt < 0.0f) dt = 0.0f;
 
-    if (!m_paused) {
+    if (m_paused) updateCamera(dt);
+    else if (m_fixedStep > 0.0f) {
+        int steps = 0;
+
+        m_stepAccumulator += dt;
+
+        while (m_stepAccumulator >= m_fixedStep && !m_paused) {
+            m_stepAccumulator -= m_fixedStep;
+            updateSimulation(m_fixedStep);
+            updateTrail(m_fixedStep);
+            ++steps;
+        }
+
+        if (steps == 0) updateCamera(dt);
+    } else {
         updateSimulation(dt);
         updateTrail(dt);
-    } else updateCamera(dt);
+    }
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     setupProjection();
     setupView();
     drawScene3D();
 
+    // runs to the end of the frame: the HUD and, with F3, the overlay
+    const FrameTrace::Zone hud_zone("hud");
     const int margin = 12, hud_height = 48;
     QRect hud_rect(
         margin,
@@ -302,6 +213,8 @@ void SinglePlayerGameProcess::paintGL() {
         botsStr
     );
 
+    if (m_showDebug) drawDebugOverlay(p);
+
     if (m_roundOver) {
         QFont f2 = p.font();
         f2.setPointSize(36);
@@ -337,11 +250,17 @@ void SinglePlayerGameProcess::keyPressEvent(QKeyEvent* event) {
     else if (event->key() == key_backward || event->key() == Qt::Key_Down) m_keyBackward = true;
     else if (event->key() == key_left || event->key() == Qt::Key_Left) m_keyLeft = true;
     else if (event->key() == key_right || event->key() == Qt::Key_Right) m_keyRight = true;
+    else if (event->key() == Qt::Key_F3) m_showDebug = !m_showDebug;
+    else if (event->key() == Qt::Key_F4) {
+        // first press starts a timeline capture, the second one saves it to the working directory
+        if (FrameTrace::capturing()) FrameTrace::save(QString("lohotron-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+        else FrameTrace::start();
+    }
     else if (event->key() == Qt::Key_Escape) {
-        if (pauseWindow->isVisible()) pauseWindow->reject();
+        if (pauseWindow && pauseWindow->isVisible()) pauseWindow->reject();
         else {
             m_paused = true;
-            pauseWindow->exec();
+            pauseDialog()->exec();
         }
     }
 
@@ -420,224 +339,97 @@ void SinglePlayerGameProcess::mouseMoveEvent(QMouseEvent* event) {
     QOpenGLWidget::mouseMoveEvent(event);
 }
 
-void SinglePlayerGameProcess::onTick() { update(); }
-
-void SinglePlayerGameProcess::updateSimulation(float dt) {
-    if (dt <= 0.0f) return;
-
-    m_time += dt;
+void SinglePlayerGameProcess::onTick() {
+    const FrameTrace::Zone zone("tick");
 
-    float bikeRadius = 0.8f, trailRadius = 0.3f;
-    int n = static_cast<int>(m_bikes.size());
-
-    if (!m_roundOver) {
-        int aliveCount = 0;
-        
-        for (int i = 0; i < n; ++i) if (m_bikes[i].alive) ++aliveCount;
-
-        if (aliveCount <= 1) {
-            m_roundOver = true;
-
-            bool playerAlive = m_bikes[0].alive;
+    update();
+}
 
-            if (playerAlive) ++m_roundsWon;
-            else {
-                ++m_roundsLost;
-                ++m_botsCrashedIntoPlayer;
-            }
+void SinglePlayerGameProcess::updateSimulation(float dt) {
+    const FrameTrace::Zone zone("updateSimulation");
 
-            if (m_currentRound >= m_roundsCount) {
-                m_matchOver = true;
-                m_paused = true;
-                gameOverWindow->sfx()->play();
-                music_player->stop();
-                gameOverWindow->setMatchResult(m_roundsWon > m_roundsLost, m_botsCrashedIntoPlayer, m_roundsWon);
-                gameOverWindow->show();
-            } else {
-                ++m_currentRound; 
-                m_roundOver = true;
-                m_paused = true;
-                m_roundText = "ROUND OVER\nPress any key";
-            }
-        }
-    }
+    if (dt <= 0.0f || m_sim.bikes().empty()) return;
 
     if (m_paused || m_matchOver) return;
 
-    for (int i = 0; i < n; ++i) {
-        Bike& b = m_bikes[i];
-
-        if (!b.alive) continue;
-
-        b.prevPos = b.pos;
-
-        float turnInput = 0.0f;
-        bool moveForward = false;
-
-        if (b.human) {
-            if (m_keyLeft) turnInput += 1.0f;
-
-            if (m_keyRight) turnInput -= 1.0f;
+    float turnInput = 0.0f;
 
-            moveForward = true;
-        } else {
-            moveForward = true;
+    if (m_keyLeft) turnInput += 1.0f;
 
-            const float lookAheadDist = 200.0f, avoidThreshold = 2.0f, attackDist2 = 400.0f, minDotAttack = 0.1f;
-            const Bike& player = m_bikes[0];
-            QVector3D localForward(0, 0, -1);
-            QMatrix4x4 rot;
-            rot.setToIdentity();
-            rot.rotate(b.yaw * 180.0f / static_cast<float>(M_PI), 0, 1, 0);
+    if (m_keyRight) turnInput -= 1.0f;
 
-            QVector3D forwardDir = rot.map(localForward).normalized();
-            QVector3D rightDir(forwardDir.z(), 0, -forwardDir.x());
+    m_sim.setTurnInput(0, turnInput);
+    m_sim.step(dt);
+    drainEvents();
 
-            bool needAvoid = false;
-            float avoidTurn = 0.0f;
-
-            for (int owner = 0; owner < n && !needAvoid; ++owner) {
-                const auto& trail = m_bikeTrails[owner];
-
-                if (trail.empty()) continue;
-
-                for (const auto& tp : trail) {
-                    QVector3D p = tp.pos;
-                    p.setY(0);
-
-                    QVector3D v = p - b.pos;
-                    v.setY(0);
-
-                    float proj = QVector3D::dotProduct(v, forwardDir);
-
-                    if (proj < 0 || proj > lookAheadDist) continue;
-
-                    QVector3D projPoint = b.pos + forwardDir * proj;
-                    projPoint.setY(0);
-
-                    QVector3D diff = p - projPoint;
-                    diff.setY(0);
-
-                    if (diff.lengthSquared() <= avoidThreshold * avoidThreshold) {
-                        float side = QVector3D::dotProduct(p - b.pos, rightDir);
-
-                        avoidTurn = (side >= 0.0f) ? -1.0f : 1.0f;
-                        needAvoid = true;
-                        break;
-                    }
-                }
-            }
-
-            if (needAvoid) turnInput = avoidTurn;
-            else {
-                QVector3D toPlayer = player.pos - b.pos;
-                toPlayer.setY(0);
-
-                float dist2 = toPlayer.lengthSquared();
-
-                if (dist2 > 0.0001f) toPlayer.normalize();
-
-                float dotForward = QVector3D::dotProduct(forwardDir, toPlayer);
-
-                if (dist2 <= attackDist2 && dotForward > minDotAttack) {
-                    float side = QVector3D::dotProduct(toPlayer, rightDir.normalized());
-
-                    turnInput = (side > 0) ? -1.0f : 1.0f;
-                    turnInput *= 0.4f + 0.4f * (static_cast<float>(std::rand()) / RAND_MAX);
-                } else {
-                    b.aiTurnTimer -= dt;
-
-                    if (b.aiTurnTimer <= 0.0f) {
-                        b.aiTurnTimer = 0.5f + static_cast<float>(std::rand()) / RAND_MAX * 1.5f;
-
-                        float r = static_cast<float>(std::rand()) / RAND_MAX;
-
-                        if (r < 0.3f) b.aiTurnDir = -1.0f;
-                        else if (r > 0.7f) b.aiTurnDir = 1.0f;
-                        else b.aiTurnDir = 0.0f;
-                    }
+    if (!m_roundOver) updateCamera(dt);
+}
 
-                    turnInput = b.aiTurnDir;
-                }
+// HUD counters, sounds and the round and match flow all follow the simulation's events
+void SinglePlayerGameProcess::drainEvents() {
+    const FrameTrace::Zone zone("drainEvents");
+
+    GameEvent events[64];
+    int count;
+
+    while ((count = m_events.read(m_eventReader, events, 64)) > 0) {
+        for (int k = 0; k < count; ++k) {
+            const GameEvent& e = events[k];
+
+            switch (e.type) {
+            case GameEvent::RoundStarted:
+                SfxBank::instance()->play(SfxBank::RoundStart);
+                break;
+            case GameEvent::BikeKilled:
+                killBike(e.bike);
+                break;
+            case GameEvent::NearMiss:
+                if (e.bike == 0) ++m_nearMisses;
+
+                break;
+            case GameEvent::RoundEnded:
+                endRound(e.bike == 0);
+                break;
+            case GameEvent::MatchEnded:
+                m_matchOver = true;
+                m_paused = true;
+                emit matchOver(m_roundsWon > m_roundsLost, m_botsCrashedIntoPlayer, m_roundsWon);
+                break;
             }
         }
-
-        float currentTurnSpeed = (turnInput > 0) ? m_turnSpeed : (turnInput < 0) ? -m_turnSpeed : 0.0f;
-
-        b.yaw = wrapPi(b.yaw + currentTurnSpeed * dt);
-
-        QMatrix4x4 rot2;
-        rot2.setToIdentity();
-        rot2.rotate(b.yaw * 180.0f / static_cast<float>(M_PI), 0, 1, 0);
-
-        QVector3D dir = rot2 * QVector3D(0, 0, -1);
-        float maxSpeed = m_maxForwardSpeed;
-        float accelFactor = m_acceleration, decelFactor = m_friction;
-
-        if (moveForward) b.speed += (maxSpeed - b.speed) * accelFactor * dt;
-        else b.speed += (-b.speed) * decelFactor * dt;
-    
-        b.speed = qBound(0.0f, b.speed, maxSpeed);
-
-        QVector3D newPos = b.pos + dir.normalized() * b.speed * dt;
-        float border = m_mapHalfSize - m_cellSize * 2.0f;
-
-        newPos.setX(qBound(-border, newPos.x(), border));
-        newPos.setZ(qBound(-border, newPos.z(), border));
-
-        b.pos = b.currPos = newPos;
-
-        auto& trail = m_bikeTrails[i];
-
-        if (trail.empty() || (b.pos - trail.back().pos).length() >= m_trailMinDist) trail.push_back({b.pos, m_time});
     }
+}
 
-    for (int i = 0; i < n; ++i) {
-        if (!m_bikes[i].alive) continue;
-
-        for (int j = i + 1; j < n; ++j) {
-            if (!m_bikes[j].alive) continue;
+void SinglePlayerGameProcess::endRound(bool playerWon) {
+    m_roundOver = true;
 
-            if ((m_bikes[i].pos - m_bikes[j].pos).lengthSquared() <= bikeRadius * 2 * bikeRadius * 2) {
-                killBike(i);
-                killBike(j);
-            }
-        }
+    if (playerWon) ++m_roundsWon;
+    else {
+        ++m_roundsLost;
+        ++m_botsCrashedIntoPlayer;
     }
 
-    for (int i = 0; i < n; ++i) {
-        if (!m_bikes[i].alive) continue;
-
-        Bike& A = m_bikes[i];
-        float hitR2 = (bikeRadius + trailRadius) * (bikeRadius + trailRadius);
-
-        for (int owner = 0; owner < n; ++owner) {
-            const auto& trail = m_bikeTrails[owner];
-
-            if (trail.empty()) continue;
-
-            for (const auto& tp : trail) {
-                if (owner == i && (m_time - tp.time) < 0.1f) continue;
+    if (m_currentRound >= m_roundsCount) {
+        GameEvent e{};
 
-                if ((A.pos - tp.pos).lengthSquared() <= hitR2) {
-                    killBike(i);
-                    break;
-                }
-            }
+        e.type = GameEvent::MatchEnded;
+        e.round = static_cast<quint16>(m_sim.roundId());
+        e.bike = m_roundsWon > m_roundsLost ? 0 : -1;
+        e.tick = m_sim.tick();
+        m_events.push(e);
 
-            if (!A.alive) break;
-        }
+        return;
     }
 
-    if (!m_roundOver) updateCamera(dt);
+    ++m_currentRound;
+    m_paused = true;
+    m_roundText = "ROUND OVER\nPress any key";
 }
 
-
-
 void SinglePlayerGameProcess::updateCamera(float dt) {
-    if (m_bikes.empty()) return;
+    if (m_sim.bikes().empty()) return;
 
-    const Bike& player = m_bikes[0];
+    const GameSimulation::Bike& player = m_sim.bikes()[0];
 
     QVector3D desiredTarget = player.pos + QVector3D(0.0f, m_camTargetHeight, 0.0f);
     float t = 1.0f - std::exp(-m_camSmooth * dt);
@@ -650,14 +442,9 @@ void SinglePlayerGameProcess::updateCamera(float dt) {
 }
 
 void SinglePlayerGameProcess::updateTrail(float dt) {
-    if (m_trailTTL <= 0.0f) return;
-
-    for (size_t i = 0; i < m_bikeTrails.size(); ++i) {
-        std::vector<TrailPoint>& trail = m_bikeTrails[i];
-
-        while (!trail.empty() && (m_time - trail.front().time) > m_trailTTL) trail.erase(trail.begin());
-    }
+    const FrameTrace::Zone zone("updateTrail");
 
+    m_sim.expireTrails();
     Q_UNUSED(dt);
 }
 
@@ -676,7 +463,7 @@ void SinglePlayerGameProcess::setupProjection() {
 }
 
 void SinglePlayerGameProcess::setupView() {
-    if (m_bikes.empty()) return;
+    if (m_sim.bikes().empty()) return;
 
     float cp = std::cos(m_camPitch), sp = std::sin(m_camPitch), cy = std::cos(m_camYaw), sy = std::sin(m_camYaw);
     QVector3D forward(sy * cp, sp, -cy * cp);
@@ -685,6 +472,8 @@ void SinglePlayerGameProcess::setupView() {
     view.setToIdentity();
     view.lookAt(eye, m_camTarget, up);
 
+    m_camEye = eye;
+
     glMatrixMode(GL_MODELVIEW);
     glLoadMatrixf(view.constData());
 }
@@ -696,7 +485,10 @@ void SinglePlayerGameProcess::drawScene3D() {
 }
 
 void SinglePlayerGameProcess::drawGroundGrid() {
-    float half = m_mapHalfSize;
+    const FrameTrace::Zone zone("drawGroundGrid");
+
+    float half = m_sim.mapHalfSize(), cellSize = m_sim.cellSize();
+    int gridSize = m_sim.gridSize();
 
     glDisable(GL_TEXTURE_2D);
     glBegin(GL_QUADS);
@@ -710,8 +502,8 @@ void SinglePlayerGameProcess::drawGroundGrid() {
     glBegin(GL_LINES);
     glColor3f(0.0f, 0.6f, 1.0f);
 
-    for (int i = 0; i <= m_gridSize; ++i) {
-        float p = (static_cast<float>(i) * m_cellSize) - half;
+    for (int i = 0; i <= gridSize; ++i) {
+        float p = (static_cast<float>(i) * cellSize) - half;
 
         glVertex3f(-half, -0.49f, p);
         glVertex3f(half, -0.49f, p);
@@ -727,10 +519,17 @@ void SinglePlayerGameProcess::showEvent(QShowEvent* event) {
     resetGameSlot();
 }
 
+// the game only ticks while its page is the current one
+void SinglePlayerGameProcess::hideEvent(QHideEvent* event) {
+    if (m_tickTimer) m_tickTimer->stop();
+
+    QOpenGLWidget::hideEvent(event);
+}
+
 void SinglePlayerGameProcess::resetGameSlot() { resetGame(true); }
 
 void SinglePlayerGameProcess::resetGame(bool newMatch) {
-    music_player->play();
+    MusicService::instance()->play();
     m_matchOver = false;
     m_paused = false;
     m_roundOver = false;
@@ -742,102 +541,31 @@ void SinglePlayerGameProcess::resetGame(bool newMatch) {
         m_roundsWon = 0;
         m_roundsLost = 0;
         m_botsCrashedIntoPlayer = 0;
+        m_nearMisses = 0;
     }
 
     if (m_botCount < 1) m_botCount = 1;
 
-    int total = 1 + m_botCount;   
-
-    m_bikes.clear();
-    m_bikeTrails.clear();
-    m_bikes.resize(total);
-    m_bikeTrails.resize(total);
     m_totalBots = m_botCount;
     m_aliveBots = m_botCount;
-    m_time = 0.0f;
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    if (m_bikes.empty()) return;
-
-    QVector3D colors[6] = {
-        QVector3D(0.243f, 0.337f, 0.133f),
-        QVector3D(0.141f, 0.431f, 0.725f),
-        QVector3D(0.306f, 0.008f, 0.314f),
-        QVector3D(0.918f, 0.604f, 0.698f),
-        QVector3D(0.22f, 0.302f, 0.282f),
-        QVector3D(0.8f, 0.247f, 0.047f)
-    };
+    m_sim.setBotCount(m_botCount);
+    m_sim.setHumanSlots(1);
+    m_sim.setHumanColor(colorForIndex(getColor()));
+    m_sim.resetRound();
+    drainEvents();
 
-    Bike& player_bike = m_bikes[0];
-    float spawnRadius = m_mapHalfSize * 0.75f;
-    float player_baseAngle = 0, jitter = (static_cast<float>(std::rand()) / RAND_MAX - 0.5f) * 0.4f;
-    float player_angle = player_baseAngle + jitter, player_radiusJitter = 0.15f * spawnRadius;
-    float r = spawnRadius - player_radiusJitter + (static_cast<float>(std::rand()) / RAND_MAX) * player_radiusJitter;
-    float z = std::sin(player_angle) * r;
-
-    player_bike.pos = QVector3D(0, 0.0f, z);
-    player_bike.yaw = static_cast<float>(M_PI) - player_angle;
-    player_bike.speed = 0.0f;
-    player_bike.lean = 0.0f;
-    player_bike.color = colors[getColor()];
-    player_bike.human = true;
-    player_bike.alive = true;
-    player_bike.prevPos = player_bike.pos;
-    player_bike.currPos = player_bike.pos;
-    player_bike.aiTurnTimer = 0.5f + static_cast<float>(std::rand()) / RAND_MAX;
-    player_bike.aiTurnDir = 0.0f;
-    m_bikeTrails[0].clear();
-
-    TrailPoint player_tp;
-    player_tp.pos = player_bike.pos;
-    player_tp.time = m_time;
-
-    m_bikeTrails[0].push_back(player_tp);
-
-    for (int i = 1; i < total; ++i) {
-        Bike& b = m_bikes[i];
-        float baseAngle = (static_cast<float>(i) / total) * 2.0f * static_cast<float>(M_PI);
-
-        jitter = (static_cast<float>(std::rand()) / RAND_MAX - 0.5f) * 0.4f;
-
-        float angle = baseAngle + jitter, radiusJitter = 0.15f * spawnRadius;
-
-        r = spawnRadius - radiusJitter + (static_cast<float>(std::rand()) / RAND_MAX) * radiusJitter;
-
-        float x = std::cos(angle) * r, z = std::sin(angle) * r;
-
-        b.pos = QVector3D(x, 0.0f, z);
-        b.yaw = -angle + static_cast<float>(M_PI); 
-        b.speed = 0.0f;
-        b.lean = 0.0f;
-        b.color = colors[5];
-        b.human = (i == 0);
-        b.alive = true;
-        b.prevPos = b.pos;
-        b.currPos = b.pos;
-        b.aiTurnTimer = 0.5f + static_cast<float>(std::rand()) / RAND_MAX;
-        b.aiTurnDir = 0.0f;
-        m_bikeTrails[i].clear();
-        
-        TrailPoint tp;
-        tp.pos = b.pos;
-        tp.time = m_time;
-
-        m_bikeTrails[i].push_back(tp);
-    }
-
-    if (m_tickTimer) m_tickTimer->start(16);
+    if (m_tickTimer && isVisible()) m_tickTimer->start(16);
 }
 
 
 void SinglePlayerGameProcess::drawBike() {
+    const FrameTrace::Zone zone("drawBike");
+
     float rad2deg = 180.0f / static_cast<float>(M_PI);
 
     glDisable(GL_BLEND);
 
-    for (size_t i = 0; i < m_bikes.size(); ++i) {
-        const Bike& b = m_bikes[i];
-        
+    for (const GameSimulation::Bike& b : m_sim.bikes()) {
         if (!b.alive) continue;
 
         glPushMatrix();
@@ -884,36 +612,186 @@ void SinglePlayerGameProcess::drawBike() {
 }
 
 
+void SinglePlayerGameProcess::loadTrailLodSettings() {
+    QJsonObject root = loadConfigRoot();
+    QJsonObject graphics = root.value("graphics").toObject();
+
+    m_trailLodNear = static_cast<float>(graphics.value("trail_lod_near").toDouble(60.0));
+    m_trailLodFar = static_cast<float>(graphics.value("trail_lod_far").toDouble(160.0));
+    m_trailLodMergeDist = static_cast<float>(graphics.value("trail_lod_merge_dist").toDouble(6.0));
+    m_trailLodReferenceBikes = graphics.value("trail_lod_reference_bikes").toInt(8);
+
+    if (m_trailLodNear < 0.0f) m_trailLodNear = 0.0f;
+
+    if (m_trailLodFar < m_trailLodNear) m_trailLodFar = m_trailLodNear;
+
+    if (m_trailLodMergeDist < 0.35f) m_trailLodMergeDist = 0.35f;
+
+    if (m_trailLodReferenceBikes < 1) m_trailLodReferenceBikes = 1;
+}
+
+// "simulation.deterministic" runs the arena at a fixed tick with a fixed seed, so the same
+// inputs replay the same match; see GameSimulation::checksum()
+void SinglePlayerGameProcess::loadSimulationSettings() {
+    QJsonObject root = loadConfigRoot();
+    QJsonObject simulation = root.value("simulation").toObject();
+
+    // written by lohoTRON_tune; absent keys keep the built-in values
+    m_sim.setBotParams(GameSimulation::botParamsFromJson(root.value("environment").toObject().value("bot_params").toObject()));
+
+    // classic mode: walls stay up for the whole round instead of fading after a second
+    if (simulation.value("persistent_walls").toBool(false)) m_sim.setTrailTTL(0.0f);
+
+    m_fixedStep = 0.0f;
+    m_stepAccumulator = 0.0f;
+
+    if (!simulation.value("deterministic").toBool(false)) return;
+
+    int tick_rate = std::clamp(simulation.value("tick_rate").toInt(60), 10, 240);
+
+    m_fixedStep = 1.0f / static_cast<float>(tick_rate);
+    m_sim.setSeed(static_cast<quint64>(simulation.value("seed").toInteger(1)));
+}
+
+void SinglePlayerGameProcess::drawDebugOverlay(QPainter& p) {
+    const FrameTrace::Zone zone("drawDebugOverlay");
+
+    const GameSimulation::AiStats& ai = m_sim.aiStats();
+    QStringList lines;
+
+    lines << QString("AI  %1 / %2 due thought, %3 deferred, max lag %4")
+        .arg(ai.thought).arg(ai.due).arg(ai.deferred).arg(ai.maxLag);
+    lines << QString("AI  %1 ms of %2 ms budget (%3 bots)")
+        .arg(ai.nanoseconds / 1e6, 0, 'f', 2)
+        .arg(ai.budgetNanoseconds > 0 ? QString::number(ai.budgetNanoseconds / 1e6, 'f', 2) : QString("count"))
+        .arg(ai.bots);
+
+    const PathPlanner& planner = m_sim.pathPlanner();
+
+    lines << QString("PLAN %1 routes, %2 searches queued, %3 nodes expanded")
+        .arg(planner.routesCached()).arg(planner.searchesQueued()).arg(planner.nodesExpanded());
+
+    if (FrameTrace::capturing()) lines << QString("TRACE capturing, F4 saves the timeline");
+
+    lines << QString("EVT  %1 written, %2 lost, %3 near misses this match")
+        .arg(m_events.written()).arg(m_eventReader.lost).arg(m_nearMisses);
+
+    const RoundArena& arena = m_sim.roundArena();
+
+    lines << QString("MEM  round arena %1 / %2 KiB, high water %3 KiB, %4 overflows")
+        .arg(arena.used() / 1024).arg(arena.capacity() / 1024).arg(arena.highWater() / 1024).arg(arena.overflows());
+
+    QFont f("Monospace");
+    f.setStyleHint(QFont::TypeWriter);
+    f.setPointSize(11);
+
+    p.save();
+    p.setFont(f);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(0, 0, 0, 160));
+    p.drawRect(8, 8, 460, 12 + 18 * lines.size());
+    p.setPen(QColor(0, 255, 128));
+
+    for (int i = 0; i < lines.size(); ++i) p.drawText(16, 26 + 18 * i, lines[i]);
+
+    // danger field as a top-down map: red on walls, fading out to clear at the distance cap
+    const DangerField& field = m_sim.dangerField();
+    QImage map(field.width(), field.height(), QImage::Format_ARGB32);
+
+    for (int y = 0; y < field.height(); ++y) {
+        QRgb* row = reinterpret_cast<QRgb*>(map.scanLine(y));
+
+        for (int x = 0; x < field.width(); ++x) {
+            const int d = field.distance(x, y);
+            const int a = 220 - 200 * d / DangerField::maxDistance;
+
+            row[x] = qRgba(255, 255 * d / DangerField::maxDistance, 0, a);
+        }
+    }
+
+    const int side = std::min(260, height() - 80);
+    const QRect area(8, height() - side - 8, side, side);
+    const float scale = static_cast<float>(side) / static_cast<float>(field.width());
+
+    p.drawImage(area, map);
+    p.setPen(Qt::NoPen);
+
+    for (const GameSimulation::Bike& b : m_sim.bikes()) {
+        if (!b.alive) continue;
+
+        const auto c = m_sim.cellOf(b.pos);
+
+        p.setBrush(b.human ? QColor(0, 200, 255) : QColor(255, 255, 255));
+        p.drawEllipse(QPointF(area.left() + (c.first + 0.5f) * scale, area.top() + (c.second + 0.5f) * scale), 3.0, 3.0);
+    }
+
+    p.restore();
+}
+
 void SinglePlayerGameProcess::drawTrail() {
+    const FrameTrace::Zone zone("drawTrail");
+
+    if (m_sim.trailTTL() <= 0.0f) {
+        drawWalls();
+
+        return;
+    }
+
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
     glDisable(GL_CULL_FACE);
 
-    for (size_t i = 0; i < m_bikes.size(); ++i) {
-        const Bike& b = m_bikes[i];
-        const std::vector<TrailPoint>& trail = m_bikeTrails[i];
+    // shrinking the LOD bands as bikes are added keeps the emitted vertex count roughly flat
+    const auto& bikes = m_sim.bikes();
+    const auto& trails = m_sim.trails();
+    const float trailTTL = m_sim.trailTTL();
+    float lodScale = std::sqrt(static_cast<float>(m_trailLodReferenceBikes) / static_cast<float>(std::max<size_t>(1, bikes.size())));
+    lodScale = clampf(lodScale, 0.25f, 1.0f);
+
+    const float nearDist = m_trailLodNear * lodScale, farDist = m_trailLodFar * lodScale;
+    const float near2 = nearDist * nearDist, far2 = farDist * farDist, merge2 = m_trailLodMergeDist * m_trailLodMergeDist;
+    const float halfWidth = 0.35f, height = 3.0f, baseY = 0.0f;
+
+    m_trailLodLines.clear();
+
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        const GameSimulation::Bike& b = bikes[i];
+        const GameSimulation::Trail& trail = trails[i];
 
         if (trail.size() < 2) continue;
 
         QVector3D col = b.color;
-        float baseR = col.x(), baseG = col.y(), baseB = col.z(), halfWidth = 0.35f, height = 3.0f, baseY = 0.0f;
+        float baseR = col.x(), baseG = col.y(), baseB = col.z();
+        // far segments are merged into runs that are flushed as single lines along the wall top
+        bool hasRun = false;
+        TrailLodLine run;
+
+        auto flushRun = [&]() {
+            if (hasRun) m_trailLodLines.push_back(run);
+
+            hasRun = false;
+        };
+
+        glBegin(GL_QUADS);
 
         for (size_t k = 0; k + 1 < trail.size(); ++k) {
-            const TrailPoint& a = trail[k], c = trail[k + 1];
-            float ageA = m_time - a.time, ageC = m_time - c.time;
+            const GameSimulation::TrailPoint& a = trail[k], c = trail[k + 1];
+            float ageA = m_sim.trailAge(a), ageC = m_sim.trailAge(c);
 
-            if (ageA < 0.0f || ageA > m_trailTTL) continue;
+            if (ageA < 0.0f || ageA > trailTTL || ageC < 0.0f || ageC > trailTTL) {
+                flushRun();
 
-            if (ageC < 0.0f || ageC > m_trailTTL) continue;
+                continue;
+            }
 
-            float alphaA = 1.0f - ageA / m_trailTTL, alphaC = 1.0f - ageC / m_trailTTL;
+            float alphaA = 1.0f - ageA / trailTTL, alphaC = 1.0f - ageC / trailTTL;
 
             if (alphaA < 0.2f) alphaA = 0.2f;
 
             if (alphaC < 0.2f) alphaC = 0.2f;
 
-            QVector3D p0 = a.pos;
-            QVector3D p1 = c.pos;
+            QVector3D p0 = m_sim.trailPos(a);
+            QVector3D p1 = m_sim.trailPos(c);
 
             p0.setY(baseY);
             p1.setY(baseY);
@@ -923,6 +801,38 @@ void SinglePlayerGameProcess::drawTrail() {
 
             if (dir.lengthSquared() < 0.0001f) continue;
 
+            float dist2 = ((p0 + p1) * 0.5f - m_camEye).lengthSquared();
+
+            if (dist2 >= far2) {
+                if (!hasRun) {
+                    run.from = p0 + QVector3D(0.0f, height, 0.0f);
+                    run.color = QVector3D(baseR, baseG, baseB);
+                    run.alpha = alphaA * 0.8f;
+                    hasRun = true;
+                }
+
+                run.to = p1 + QVector3D(0.0f, height, 0.0f);
+
+                if ((run.to - run.from).lengthSquared() >= merge2) flushRun();
+
+                continue;
+            }
+
+            flushRun();
+
+            if (dist2 >= near2) {
+                // mid range: a single vertical ribbon along the trail centre line
+                glColor4f(baseR, baseG, baseB, alphaA * 0.8f);
+                glVertex3f(p0.x(), p0.y(), p0.z());
+                glColor4f(baseR, baseG, baseB, alphaC * 0.8f);
+                glVertex3f(p1.x(), p1.y(), p1.z());
+                glVertex3f(p1.x(), p1.y() + height, p1.z());
+                glColor4f(baseR, baseG, baseB, alphaA * 0.8f);
+                glVertex3f(p0.x(), p0.y() + height, p0.z());
+
+                continue;
+            }
+
             dir.normalize();
 
             QVector3D perp(-dir.z(), 0.0f, dir.x());
@@ -935,7 +845,6 @@ void SinglePlayerGameProcess::drawTrail() {
             QVector3D t3 = b3 + QVector3D(0.0f, height, 0.0f);
             QVector3D t4 = b4 + QVector3D(0.0f, height, 0.0f);
 
-            glBegin(GL_QUADS);
             glColor4f(baseR, baseG, baseB, alphaA * 0.9f);
             glVertex3f(b1.x(), b1.y(), b1.z());
             glVertex3f(b2.x(), b2.y(), b2.z());
@@ -968,26 +877,188 @@ void SinglePlayerGameProcess::drawTrail() {
             glVertex3f(t4.x(), t4.y(), t4.z());
             glVertex3f(t3.x(), t3.y(), t3.z());
             glVertex3f(b3.x(), b3.y(), b3.z());
-            glEnd();
         }
+
+        glEnd();
+        flushRun();
+    }
+
+    // all far-away runs of every bike go out in one batch
+    if (!m_trailLodLines.empty()) {
+        glLineWidth(2.0f);
+        glBegin(GL_LINES);
+
+        for (const TrailLodLine& line : m_trailLodLines) {
+            glColor4f(line.color.x(), line.color.y(), line.color.z(), line.alpha);
+            glVertex3f(line.from.x(), line.from.y(), line.from.z());
+            glVertex3f(line.to.x(), line.to.y(), line.to.z());
+        }
+
+        glEnd();
+        glLineWidth(1.0f);
     }
 
     glDisable(GL_BLEND);
     glEnable(GL_CULL_FACE);
 }
 
-float SinglePlayerGameProcess::clampf(float v, float lo, float hi) { return std::max(lo, std::min(hi, v)); }
+// two sides and the top of a wall from `from` to `to`, as quads
+void SinglePlayerGameProcess::emitWallRun(std::vector<float>& out, const QVector3D& from, const QVector3D& to) const {
+    QVector3D dir = to - from;
 
-float SinglePlayerGameProcess::lerpf(float a, float b, float t) { return a + (b - a) * t; }
+    if (dir.lengthSquared() < 0.0001f) return;
+
+    dir.normalize();
+
+    const float halfWidth = 0.35f, height = m_trailColumnHeight;
+    const QVector3D perp(-dir.z() * halfWidth, 0.0f, dir.x() * halfWidth), up(0.0f, height, 0.0f);
+    const QVector3D b1 = from - perp, b2 = from + perp, b3 = to + perp, b4 = to - perp;
+    const QVector3D corners[12] = {b1, b4, b4 + up, b1 + up, b3, b2, b2 + up, b3 + up, b1 + up, b4 + up, b3 + up, b2 + up};
+
+    for (const QVector3D& v : corners) {
+        out.push_back(v.x());
+        out.push_back(v.y());
+        out.push_back(v.z());
+    }
+}
+
+void SinglePlayerGameProcess::updateWallMesh(WallMesh& mesh, const GameSimulation::Trail& trail) {
+    if (mesh.consumed >= trail.size()) return;
+
+    // the open run is rebuilt from scratch below; closed runs stay as they are
+    mesh.vertices.resize(mesh.closedFloats);
+
+    for (size_t k = mesh.consumed; k < trail.size(); ++k) {
+        const QVector3D p = m_sim.trailPos(trail[k]);
+
+        if (!mesh.hasRun) {
+            mesh.runFrom = mesh.runTo = p;
+            mesh.runDir = QVector3D();
+            mesh.hasRun = true;
+
+            continue;
+        }
+
+        if (mesh.runDir.isNull()) {
+            if ((p - mesh.runFrom).lengthSquared() < 0.0001f) continue;
+
+            mesh.runDir = (p - mesh.runFrom).normalized();
+            mesh.runTo = p;
 
-float SinglePlayerGameProcess::wrapPi(float a) {
-    const float twoPi = 2.0f * static_cast<float>(M_PI);
+            continue;
+        }
+
+        const QVector3D rel = p - mesh.runFrom;
+        const float along = QVector3D::dotProduct(rel, mesh.runDir);
+        const QVector3D off = rel - mesh.runDir * along;
 
-    while (a <= -static_cast<float>(M_PI)) a += twoPi;
+        if (along > QVector3D::dotProduct(mesh.runTo - mesh.runFrom, mesh.runDir) && off.lengthSquared() <= wallMergeTolerance * wallMergeTolerance) {
+            mesh.runTo = p;
 
-    while (a > static_cast<float>(M_PI)) a -= twoPi;
+            continue;
+        }
+
+        // the run bends here: close it and start the next one where it ended
+        emitWallRun(mesh.vertices, mesh.runFrom, mesh.runTo);
+        mesh.closedFloats = mesh.vertices.size();
+        mesh.runFrom = mesh.runTo;
+        mesh.runDir = (p - mesh.runFrom).normalized();
+        mesh.runTo = p;
+    }
 
-    return a;
+    mesh.consumed = trail.size();
+
+    if (!mesh.runDir.isNull()) emitWallRun(mesh.vertices, mesh.runFrom, mesh.runTo);
+}
+
+void SinglePlayerGameProcess::drawWalls() {
+    const FrameTrace::Zone zone("drawWalls");
+
+    const auto& bikes = m_sim.bikes();
+    const auto& trails = m_sim.trails();
+
+    if (m_wallRound != m_sim.roundId()) {
+        m_wallRound = m_sim.roundId();
+
+        // buffers are kept for the next round; only the geometry goes
+        for (WallMesh& mesh : m_wallMeshes) {
+            mesh.vertices.clear();
+            mesh.consumed = 0;
+            mesh.closedFloats = 0;
+            mesh.hasRun = false;
+        }
+    }
+
+    if (m_wallMeshes.size() < bikes.size()) m_wallMeshes.resize(bikes.size());
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glDisable(GL_CULL_FACE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    for (size_t i = 0; i < bikes.size(); ++i) {
+        WallMesh& mesh = m_wallMeshes[i];
+        const size_t firstDirty = mesh.closedFloats;
+
+        updateWallMesh(mesh, trails[i]);
+
+        if (mesh.vertices.empty()) continue;
+
+        if (mesh.buffer == 0) glGenBuffers(1, &mesh.buffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+
+        // grows by doubling and is refilled whole then; otherwise only the tip goes up
+        if (mesh.vertices.size() > mesh.bufferFloats) {
+            mesh.bufferFloats = std::max<size_t>(mesh.vertices.size() * 2, 4096);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh.bufferFloats * sizeof(float)), nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(mesh.vertices.size() * sizeof(float)), mesh.vertices.data());
+        } else if (mesh.vertices.size() > firstDirty) {
+            glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(firstDirty * sizeof(float)), static_cast<GLsizeiptr>((mesh.vertices.size() - firstDirty) * sizeof(float)), mesh.vertices.data() + firstDirty);
+        }
+
+        const QVector3D& col = bikes[i].color;
+
+        glColor4f(col.x(), col.y(), col.z(), 0.8f);
+        glVertexPointer(3, GL_FLOAT, 0, nullptr);
+        glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(mesh.vertices.size() / 3));
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisable(GL_BLEND);
+    glEnable(GL_CULL_FACE);
+}
+
+// the meshes keep their geometry; a zero buffer is created and filled whole on the next draw
+void SinglePlayerGameProcess::releaseWallBuffers() {
+    makeCurrent();
+
+    for (WallMesh& mesh : m_wallMeshes) {
+        if (mesh.buffer != 0) glDeleteBuffers(1, &mesh.buffer);
+
+        mesh.buffer = 0;
+        mesh.bufferFloats = 0;
+    }
+
+    doneCurrent();
+}
+
+float SinglePlayerGameProcess::clampf(float v, float lo, float hi) { return std::max(lo, std::min(hi, v)); }
+
+float SinglePlayerGameProcess::lerpf(float a, float b, float t) { return a + (b - a) * t; }
+
+QVector3D SinglePlayerGameProcess::colorForIndex(unsigned short idx) {
+    static const QVector3D colors[6] = {
+        QVector3D(0.243f, 0.337f, 0.133f), // olive leaf
+        QVector3D(0.141f, 0.431f, 0.725f), // bright marine
+        QVector3D(0.306f, 0.008f, 0.314f), // dark amethyst
+        QVector3D(0.918f, 0.604f, 0.698f), // pink mist
+        QVector3D(0.22f, 0.302f, 0.282f), // dark slate grey
+        QVector3D(0.8f, 0.247f, 0.047f) // red ochre
+    };
+
+    return colors[std::min<unsigned short>(idx, 5)];
 }
 
 unsigned short SinglePlayerGameProcess::getColor() const {
@@ -1001,6 +1072,4 @@ unsigned short SinglePlayerGameProcess::getColor() const {
     else if (chosen_color == "pink") return 3;
     else if (chosen_color == "grey") return 4;
     else return 5; // let it be red for debugging purposes
-}
-
-QMediaPlayer* SinglePlayerGameProcess::music() const { return music_player; }
\ No newline at end of file
+}
\ No newline at end of file
@@ -7,10 +7,14 @@
 #include <cmath>
 #include <ctime>
 #include <cstdlib>
+#ifdef LOHOTRON_WITH_OGRE
 #include <Ogre.h>
+#endif
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
+#include <QOpenGLContext>
 #include <QPainter>
+#include <QImage>
 #include <QPen>
 #include <QKeyEvent>
 #include <QMouseEvent>
@@ -21,21 +25,27 @@
 #include <QMessageBox>
 #include <QPoint>
 #include <QMatrix4x4>
+#include <QtMath>
+#include <QDateTime>
 #include "GamePauseWindow.h"
 #include "SettingsWindow.h"
 #include "GameOverWindow.h"
-#include <QMediaPlayer>
-#include <QAudioOutput>
+#include "MusicService.h"
+#include "SfxBank.h"
+#include "GameSimulation.h"
+#include "FrameTrace.h"
 
 class SinglePlayerGameProcess : public QOpenGLWidget, protected QOpenGLFunctions {
     Q_OBJECT
 public:
     explicit SinglePlayerGameProcess(QWidget* parent = nullptr);
+    ~SinglePlayerGameProcess() override;
     void setFieldSize(int n);
     void setBotCount(int n);        
     void setRoundsCount(int n);  
+    // 0 = classic bots, 1 = territory bots (see GameSimulation::BotTier)
+    void setBotTier(int tier);
     unsigned short getColor() const;
-    QMediaPlayer* music() const;
 public slots:
     void resetGameSlot();          
 protected:
@@ -43,41 +53,50 @@ protected:
     void resizeGL(int w, int h) override;
     void paintGL() override;
     void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
     void keyReleaseEvent(QKeyEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
 
-    GamePauseWindow* pauseWindow;
+    GamePauseWindow* pauseWindow = nullptr;
 signals:
     void exitToMainMenu();
     void matchOver(bool playerWin, int killedBots, int roundsWon);
 private slots:
     void onTick();
     void exitToMenuInternal();
+    // the GL context is going away: drops the wall buffers so the next context starts clean
+    void releaseWallBuffers();
 private:
     GameOverWindow* gameOverWindow = nullptr;
 
-    struct TrailPoint {
-        QVector3D pos;
-        float time;
+    struct TrailLodLine {
+        QVector3D from;
+        QVector3D to;
+        QVector3D color;
+        float alpha;
     };
 
-    struct Bike {
-        QVector3D pos;
-        QVector3D prevPos;
-        QVector3D currPos;
-        float yaw;
-        float speed;
-        float lean;
-        QVector3D color;
-        bool human;
-        bool alive;
-        float aiTurnTimer;
-        float aiTurnDir;
+    // persistent walls of one bike: the trail merged into straight runs in a vertex buffer. Runs
+    // before the tip never change, so each frame only the open run at the tip is rewritten and
+    // uploaded, and the whole wall is one draw call
+    struct WallMesh {
+        std::vector<float> vertices;
+        // trail points folded in, floats of closed runs, and what the buffer holds
+        size_t consumed = 0;
+        size_t closedFloats = 0;
+        size_t bufferFloats = 0;
+        GLuint buffer = 0;
+        QVector3D runFrom;
+        QVector3D runTo;
+        QVector3D runDir;
+        bool hasRun = false;
     };
 
+    GamePauseWindow* pauseDialog();
+    GameOverWindow* gameOverDialog();
     void resetGame(bool newMatch);
     void updateSimulation(float dt);
     void updateCamera(float dt);
@@ -87,24 +106,35 @@ private:
     void drawScene3D();
     void drawGroundGrid();
     void killBike(int idx);
+    void drainEvents();
+    void endRound(bool playerWon);
     void drawBike();
     void drawTrail();
+    void drawWalls();
+    void updateWallMesh(WallMesh& mesh, const GameSimulation::Trail& trail);
+    void emitWallRun(std::vector<float>& out, const QVector3D& from, const QVector3D& to) const;
+    void drawDebugOverlay(QPainter& p);
+    void loadTrailLodSettings();
+    void loadSimulationSettings();
     static float clampf(float v, float lo, float hi);
     static float lerpf(float a, float b, float t);
-    static float wrapPi(float a);
+    static QVector3D colorForIndex(unsigned short idx);
 
     bool m_gameOverShown = false;
+    // F3: profiling overlay
+    bool m_showDebug = false;
+#ifdef LOHOTRON_WITH_OGRE
     std::unique_ptr<Ogre::Root> m_root;
     Ogre::SceneManager* m_scene_manager;
     Ogre::RenderWindow* m_render_window;
+#endif
     int m_fieldSize;
-    int m_gridSize;
-    float m_cellSize;
-    float m_mapHalfSize;
     bool m_paused;
-    Bike m_bike;
-    std::vector<Bike> m_bikes;
-    std::vector<std::vector<TrailPoint>> m_bikeTrails;
+    GameSimulation m_sim;
+    EventStream m_events;
+    EventStream::Reader m_eventReader;
+    // the player's near misses this match, for the F3 overlay
+    int m_nearMisses = 0;
     float m_camYaw;
     float m_camPitch;
     float m_camDistance;
@@ -131,28 +161,33 @@ private:
     bool m_keyBackward;
     bool m_keyLeft;
     bool m_keyRight;
-    float m_maxForwardSpeed;
     float m_maxBackwardSpeed;
-    float m_acceleration;
     float m_brakeDecel;
-    float m_friction;
-    float m_turnSpeed;
     float m_maxLeanAngle;
     bool m_roundOver = false;
     int m_playerRank = 0;
     int m_deadCount = 0;
     QString m_roundText = "РАУНД ЗАКОНЧЕН\nНажмите любую клавишу";
     float m_leanSpeed;
-    float m_trailTTL;
-    float m_trailMinDist;
     float m_trailColumnSize;
     float m_trailColumnHeight;
+    // trail LOD: full walls closer than near, single-quad ribbons up to far, merged lines beyond
+    float m_trailLodNear;
+    float m_trailLodFar;
+    float m_trailLodMergeDist;
+    int m_trailLodReferenceBikes;
+    QVector3D m_camEye;
+    std::vector<TrailLodLine> m_trailLodLines;
+    // a point further than this off the open run's line starts a new run
+    static constexpr float wallMergeTolerance = 0.05f;
+    std::vector<WallMesh> m_wallMeshes;
+    int m_wallRound = -1;
     QElapsedTimer m_timer;
     qint64 m_lastTimeMs;
-    float m_time;
+    // deterministic mode: fixed step in seconds (0 = step once per frame) and the leftover frame time
+    float m_fixedStep;
+    float m_stepAccumulator;
     QTimer* m_tickTimer;
-    QMediaPlayer* music_player;
-    QAudioOutput* music_output;
 };
 
 #endif // SINGLEPLAYERGAMEPROCESS_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "TrailGrid.h"
+#include <algorithm>
+
+void TrailGrid::reset(int width, int height) {
+    m_width = std::max(1, width);
+    m_height = std::max(1, height);
+    m_heads.assign(static_cast<size_t>(m_width) * m_height, -1);
+    m_entries.clear();
+    m_free = -1;
+    m_points = 0;
+}
+
+int TrailGrid::points() const { return m_points; }
+
+void TrailGrid::add(int cx, int cy, const Point& p, int owner) {
+    if (cx < 0 || cy < 0 || cx >= m_width || cy >= m_height) return;
+
+    int e = m_free;
+
+    if (e >= 0) m_free = m_entries[e].next;
+    else {
+        e = static_cast<int>(m_entries.size());
+        m_entries.push_back({});
+    }
+
+    int& head = m_heads[cy * m_width + cx];
+
+    m_entries[e] = {p, static_cast<quint16>(owner), head};
+    head = e;
+    ++m_points;
+}
+
+bool TrailGrid::remove(int cx, int cy, const Point& p, int owner) {
+    if (cx < 0 || cy < 0 || cx >= m_width || cy >= m_height) return false;
+
+    for (int* link = &m_heads[cy * m_width + cx]; *link >= 0; link = &m_entries[*link].next) {
+        Entry& e = m_entries[*link];
+
+        if (e.owner != owner || e.p.x != p.x || e.p.z != p.z || e.p.ms != p.ms) continue;
+
+        const int freed = *link;
+
+        *link = e.next;
+        e.next = m_free;
+        m_free = freed;
+        --m_points;
+
+        return true;
+    }
+
+    return false;
+}
+
+int TrailGrid::firstHit(int cx0, int cy0, int cx1, int cy1, const Point& p, qint64 radius2, int self, const Point* grace, int graceCount, Closest* closest) const {
+    int hit = -1;
+
+    cx0 = std::max(cx0, 0);
+    cy0 = std::max(cy0, 0);
+    cx1 = std::min(cx1, m_width - 1);
+    cy1 = std::min(cy1, m_height - 1);
+
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            for (int k = m_heads[cy * m_width + cx]; k >= 0; k = m_entries[k].next) {
+                const Entry& e = m_entries[k];
+                const qint64 dx = e.p.x - p.x, dz = e.p.z - p.z, d2 = dx * dx + dz * dz;
+
+                if (closest && e.owner != self && d2 < closest->distance2) {
+                    closest->distance2 = d2;
+                    closest->owner = e.owner;
+                }
+
+                if (d2 > radius2 || (hit >= 0 && e.owner >= hit)) continue;
+
+                // matched by value rather than by age: drop times wrap, so an old point can look young
+                if (e.owner == self && std::any_of(grace, grace + graceCount, [&e](const Point& g) { return g.x == e.p.x && g.z == e.p.z && g.ms == e.p.ms; })) continue;
+
+                hit = e.owner;
+            }
+        }
+    }
+
+    return hit;
+}
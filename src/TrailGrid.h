@@ -0,0 +1,58 @@
+#ifndef TRAILGRID_H
+#define TRAILGRID_H
+
+// Trail points bucketed by arena cell for the collision test. Every cell heads
+// a singly linked chain of entries kept in one pool; removed entries go on a
+// free list and reset() keeps the pool's storage, so once a round has been
+// played adding points doesn't allocate. A query walks only the cells its
+// radius touches, so it costs as much as those cells are crowded, however long
+// the trails have grown, which is what lets walls stay up for a whole round.
+// Coordinates are the simulation's packed trail points (16-bit fixed point);
+// the caller picks the cell, so it always agrees with its own cellOf().
+
+#include <QtGlobal>
+#include <vector>
+
+class TrailGrid {
+public:
+    // the simulation's packed trail point; GameSimulation::TrailPoint describes the format
+    struct Point {
+        qint16 x;
+        qint16 z;
+        quint16 ms;
+    };
+
+    // nearest point of another owner, for near-miss reports
+    struct Closest {
+        qint64 distance2;
+        int owner = -1;
+    };
+
+    // forgets every point
+    void reset(int width, int height);
+    void add(int cx, int cy, const Point& p, int owner);
+    // drops one entry equal to p; false if the cell doesn't hold it
+    bool remove(int cx, int cy, const Point& p, int owner);
+    // lowest owner with a point within sqrt(radius2) steps of p in the inclusive cell rectangle, or -1.
+    // points of `self` equal to one of the `graceCount` points at `grace` (the newest ones of its own
+    // trail) are ignored. `closest`, if given, is lowered to the nearest point in the rectangle owned by
+    // someone other than `self`
+    int firstHit(int cx0, int cy0, int cx1, int cy1, const Point& p, qint64 radius2, int self, const Point* grace, int graceCount, Closest* closest = nullptr) const;
+
+    int points() const;
+private:
+    struct Entry {
+        Point p;
+        quint16 owner;
+        int next;
+    };
+
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<int> m_heads;
+    std::vector<Entry> m_entries;
+    int m_free = -1;
+    int m_points = 0;
+};
+
+#endif // TRAILGRID_H
@@ -0,0 +1,119 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QDebug>
+#include "BotTuner.h"
+
+static bool writeJson(const QString& path, const QJsonObject& root) {
+    QFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "cannot write" << path << file.errorString();
+
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+
+    return true;
+}
+
+// puts the parameters under environment.bot_params of an existing game_config.json, keeping everything else
+static bool mergeIntoConfig(const QString& path, const QJsonObject& params) {
+    QJsonObject root;
+    QFile file(path);
+
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+
+        file.close();
+
+        // a broken config is the user's to fix; writing ours over it would lose everything else in it
+        if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+            qWarning() << "cannot parse" << path << error.errorString() << "- leaving it untouched";
+
+            return false;
+        }
+
+        root = doc.object();
+    }
+
+    QJsonObject environment = root.value("environment").toObject();
+
+    environment["bot_params"] = params;
+    root["environment"] = environment;
+
+    return writeJson(path, root);
+}
+
+// Headless tuner for the classic bot constants.
+// Runs seeded bot-vs-bot self-play on every core (see BotTuner.h) and writes the
+// best parameter set as JSON; `--config game_config.json` also stores it where
+// the game picks it up.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lohoTRON_tune");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Tune the bot parameters with self-play.");
+    parser.addHelpOption();
+
+    QCommandLineOption population_option("population", "Parameter sets per generation.", "count", "24");
+    QCommandLineOption generations_option("generations", "Generations to run.", "count", "30");
+    QCommandLineOption matches_option("matches", "Matches per parameter set and generation.", "count", "64");
+    QCommandLineOption bots_option("bots", "Bikes per match, split between candidate and reference.", "count", "8");
+    QCommandLineOption field_option("field", "Arena size in cells.", "cells", "100");
+    QCommandLineOption tick_option("tick", "Simulation tick rate (Hz).", "hz", "60");
+    QCommandLineOption length_option("max-seconds", "Longest match in simulated seconds.", "seconds", "60");
+    QCommandLineOption threads_option("threads", "Worker threads.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption seed_option("seed", "Seed for the search and the matches.", "seed", "1");
+    QCommandLineOption output_option("output", "File for the tuned parameters.", "file", "bot_params.json");
+    QCommandLineOption config_option("config", "game_config.json to store the tuned parameters in.", "file");
+
+    parser.addOptions({population_option, generations_option, matches_option, bots_option, field_option, tick_option, length_option, threads_option, seed_option, output_option, config_option});
+    parser.process(app);
+
+    BotTuner::Config config;
+    config.population = parser.value(population_option).toInt();
+    config.generations = parser.value(generations_option).toInt();
+    config.matches = parser.value(matches_option).toInt();
+    config.bots = parser.value(bots_option).toInt();
+    config.fieldSize = parser.value(field_option).toInt();
+    config.tickRate = parser.value(tick_option).toInt();
+    config.maxSeconds = parser.value(length_option).toFloat();
+    config.threads = parser.value(threads_option).toInt();
+    config.seed = parser.value(seed_option).toULongLong();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    BotTuner tuner(config);
+    const BotTuner::Result best = tuner.run(
+        [&clock](int generation, const BotTuner::Result& result, double mean) {
+            qInfo().nospace() << "generation " << generation << ": best " << result.fitness << ", mean " << mean << " ("
+                << clock.elapsed() / 1000.0 << " s)";
+        }
+    );
+
+    qInfo().nospace() << "held-out fitness " << best.fitness << " (" << best.searchFitness << " on the search matches)";
+
+    const QJsonObject params = GameSimulation::botParamsToJson(best.params);
+    QJsonObject out;
+    out["bot_params"] = params;
+    out["fitness"] = best.fitness;
+    out["search_fitness"] = best.searchFitness;
+    out["seed"] = QString::number(config.seed);
+
+    if (!writeJson(parser.value(output_option), out)) return 1;
+
+    qInfo().noquote() << QJsonDocument(params).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(config_option) && !mergeIntoConfig(parser.value(config_option), params)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef LOHOTRON_ENV_H
+#define LOHOTRON_ENV_H
+
+/* Plain C interface to BatchEnv for external trainers (ctypes, cffi, ...).
+ * Buffers returned by the accessors live as long as the environment and are
+ * overwritten in place by every reset/step; see BatchEnv.h for their layout.
+ * One environment must not be used from several threads at once. */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(LOHOTRON_ENV_BUILD)
+#    define LOHOTRON_ENV_API __declspec(dllexport)
+#  else
+#    define LOHOTRON_ENV_API __declspec(dllimport)
+#  endif
+#else
+#  define LOHOTRON_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lohotron_env lohotron_env;
+
+/* threads <= 0 uses every core; returns NULL on bad arguments */
+LOHOTRON_ENV_API lohotron_env* lohotron_env_create(int arenas, int bots, int field_size, int patch, int action_repeat, int threads, uint64_t seed);
+LOHOTRON_ENV_API void lohotron_env_destroy(lohotron_env* env);
+
+LOHOTRON_ENV_API int lohotron_env_arenas(const lohotron_env* env);
+LOHOTRON_ENV_API int lohotron_env_patch_size(const lohotron_env* env);
+LOHOTRON_ENV_API int lohotron_env_state_size(const lohotron_env* env);
+
+/* both return 0, or -1 if the simulation failed (out of memory); the buffers
+ * are then undefined until a reset returns 0 */
+LOHOTRON_ENV_API int lohotron_env_reset(lohotron_env* env);
+/* one action per arena: 0 = left, 1 = straight, 2 = right */
+LOHOTRON_ENV_API int lohotron_env_step(lohotron_env* env, const int32_t* actions);
+
+LOHOTRON_ENV_API const uint8_t* lohotron_env_patches(const lohotron_env* env);
+LOHOTRON_ENV_API const float* lohotron_env_states(const lohotron_env* env);
+LOHOTRON_ENV_API const float* lohotron_env_rewards(const lohotron_env* env);
+LOHOTRON_ENV_API const uint8_t* lohotron_env_dones(const lohotron_env* env);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOHOTRON_ENV_H */
@@ -1,7 +1,10 @@
 #include <QApplication>
 #include "mainwindow.h"
 #include <QFontDatabase>
+#include <QCommandLineParser>
 #include "SettingsWindow.h"
+#include "SfxBank.h"
+#include "FrameTrace.h"
 
 // function to define default settings for first game startup
 void createDefaultRoot() {
@@ -24,6 +27,28 @@ void createDefaultRoot() {
     env_set["bots_count_min"] = 1;
     env_set["field_size"] = 150;
     root["environment"] = env_set;
+
+    QJsonObject graphics;
+    graphics["trail_lod_near"] = 60;
+    graphics["trail_lod_far"] = 160;
+    graphics["trail_lod_merge_dist"] = 6;
+    graphics["trail_lod_reference_bikes"] = 8;
+    root["graphics"] = graphics;
+
+    QJsonObject simulation;
+    simulation["deterministic"] = false;
+    simulation["seed"] = 1;
+    simulation["tick_rate"] = 60;
+    root["simulation"] = simulation;
+
+    QJsonObject netplay;
+    netplay["enabled"] = false;
+    netplay["local_player"] = 1;
+    netplay["local_port"] = 7788;
+    netplay["remote_host"] = "127.0.0.1";
+    netplay["remote_port"] = 7789;
+    netplay["input_delay"] = 0;
+    root["netplay"] = netplay;
     saveConfigRoot(root);
 }
 
@@ -41,8 +66,32 @@ int main(int argc, char* argv[]) {
 
     createDefaultRoot();
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+
+    QCommandLineOption trace_option("trace", "Record a frame timeline from startup and save it as Chrome trace JSON when the game quits.", "file");
+    QCommandLineOption trace_seconds_option("trace-seconds", "Save the --trace timeline after this many seconds instead.", "seconds", "0");
+
+    parser.addOptions({trace_option, trace_seconds_option});
+    parser.process(a);
+
+    // F4 can start a capture at any time, so the render thread's ring is set up now rather than mid-frame
+    FrameTrace::registerThread();
+
+    if (parser.isSet(trace_option)) {
+        const QString trace_path = parser.value(trace_option);
+        const int trace_seconds = parser.value(trace_seconds_option).toInt();
+
+        FrameTrace::start();
+
+        if (trace_seconds > 0) QTimer::singleShot(trace_seconds * 1000, [trace_path]() { FrameTrace::save(trace_path); });
+        else QObject::connect(&a, &QCoreApplication::aboutToQuit, [trace_path]() { FrameTrace::save(trace_path); });
+    }
+
     mainwindow w;
     w.showFullScreen();
+    // effects decode in the background right after the menu is on screen
+    QTimer::singleShot(0, []() { SfxBank::instance()->preload(); });
 
     return a.exec();
 }
\ No newline at end of file
@@ -3,34 +3,43 @@
 mainwindow::mainwindow(QWidget* parent) : QMainWindow(parent) {
     stacked = new QStackedWidget(this);
     menu = new MainMenuWidget;
-    game_proc_window = new SinglePlayerGameProcess;
-    game_proc_window->music()->stop();
+    game_proc_window = nullptr;
     stacked->addWidget(menu);
-    stacked->addWidget(game_proc_window);
     setCentralWidget(stacked);
     stacked->setCurrentWidget(menu);
+    // music starts once the event loop runs so the first frame is not held up by audio setup
+    QTimer::singleShot(0, this, []() { MusicService::instance()->play(); });
+}
+
+// the GL game widget (and everything it owns) is only built for the first match
+SinglePlayerGameProcess* mainwindow::gameWidget() {
+    if (game_proc_window) return game_proc_window;
+
+    game_proc_window = new SinglePlayerGameProcess;
+    stacked->addWidget(game_proc_window);
     connect(game_proc_window, &SinglePlayerGameProcess::exitToMainMenu, this, &mainwindow::showMenu);
+
+    return game_proc_window;
 }
 
 void mainwindow::showMenu() {
     if (stacked && menu) {
-        game_proc_window->music()->stop();
-        menu->music()->play();
+        MusicService::instance()->play();
         stacked->setCurrentWidget(menu);
     }
 }
 
-void mainwindow::startGame(int fieldSize, int botsCount,int roundsCount) {
-    menu->music()->stop();
-    game_proc_window->music()->play();
-    Q_UNUSED(botsCount);
+void mainwindow::startGame(int fieldSize, int botsCount,int roundsCount, int botTier) {
+    MusicService::instance()->play();
 
-    if (!stacked || !game_proc_window) return;
+    if (!stacked) return;
 
-    game_proc_window->resetGameSlot();
+    gameWidget();
     game_proc_window->setFieldSize(fieldSize);
     game_proc_window->setBotCount(botsCount);
     game_proc_window->setRoundsCount(roundsCount);
+    game_proc_window->setBotTier(botTier);
+    // showing the page starts the match, once, with the settings above
     stacked->setCurrentWidget(game_proc_window);
     game_proc_window->setFocus();
 }
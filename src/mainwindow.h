@@ -3,8 +3,10 @@
 
 #include <QMainWindow>
 #include <QStackedWidget>
+#include <QTimer>
 #include "MainMenuWidget.h"
 #include "SinglePlayerGameProcess.h"
+#include "MusicService.h"
 
 class mainwindow : public QMainWindow {
     Q_OBJECT
@@ -12,8 +14,10 @@ public:
     explicit mainwindow(QWidget * parent = nullptr);
 public slots:
     void showMenu();
-    void startGame(int fieldSize, int botsCount, int roundsCount);
+    void startGame(int fieldSize, int botsCount, int roundsCount, int botTier = 0);
 private:
+    SinglePlayerGameProcess* gameWidget();
+
     QStackedWidget* stacked;
     MainMenuWidget* menu;
     SinglePlayerGameProcess* game_proc_window;